@@ -0,0 +1,144 @@
+#pragma once
+// Хуки глобальных operator new/delete для проверки и профилирования выделений памяти.
+// Флаг CHECKERS_ALLOC_CHECK - тест: Logic::find_best_turns проверяет через assert,
+// что за время поиска поток поиска не выделил память (выделения других потоков - окна, ввода - не в счёт).
+// Флаг CHECKERS_ALLOC_PROFILE - профиль: кроме числа выделений считаются байты, живая память и её пик,
+// а выделения раскладываются по глубине поиска, на которой они сделаны (ALLOC_DEPTH_SCOPE в Logic).
+// Game пишет профиль каждого хода бота в log.txt рядом с "Bot turn time" (Alloc_profile).
+// Заголовок определяет глобальные функции, поэтому должен попадать только в одну единицу трансляции.
+#if defined(CHECKERS_ALLOC_CHECK) || defined(CHECKERS_ALLOC_PROFILE)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Количество выделений памяти с начала работы программы
+inline std::atomic<size_t> alloc_count{0};
+// Количество выделений памяти текущим потоком
+inline thread_local size_t alloc_thread_count = 0;
+
+#ifdef CHECKERS_ALLOC_PROFILE
+#include <cstddef>
+#include <ostream>
+
+// Корзины глубины: 0 - вне поиска, 1 + d - поиск на глубине d (0 - корень), последняя - всё глубже
+constexpr int Alloc_depths = 34;
+
+inline std::atomic<size_t> alloc_bytes{0};  // Байт выделено с начала работы
+inline std::atomic<size_t> alloc_live{0};   // Байт занято сейчас
+inline std::atomic<size_t> alloc_peak{0};   // Пик alloc_live с последнего Alloc_profile
+inline std::atomic<size_t> alloc_depth_count[Alloc_depths];
+inline std::atomic<size_t> alloc_depth_bytes[Alloc_depths];
+inline thread_local int alloc_depth = 0;  // Корзина глубины текущего потока
+
+// Размер блока хранится перед ним, чтобы delete знал, сколько памяти освобождается
+constexpr size_t Alloc_header = alignof(std::max_align_t);
+
+// Помечает выделения внутри области глубиной поиска depth
+class Alloc_depth_scope
+{
+  public:
+    explicit Alloc_depth_scope(const int depth) : prev(alloc_depth)
+    {
+        alloc_depth = (depth + 1 < Alloc_depths ? depth + 1 : Alloc_depths - 1);
+    }
+    ~Alloc_depth_scope()
+    {
+        alloc_depth = prev;
+    }
+
+  private:
+    int prev;
+};
+
+// Профиль выделений за интервал: создаётся в начале хода, write печатает разницу счётчиков.
+// Учитываются выделения всех потоков (поиск, отрисовка, журнал), пик живой памяти - с начала интервала
+class Alloc_profile
+{
+  public:
+    Alloc_profile() : count(alloc_count), bytes(alloc_bytes)
+    {
+        alloc_peak = alloc_live.load();
+        for (int d = 0; d < Alloc_depths; ++d)
+        {
+            depth_count[d] = alloc_depth_count[d];
+            depth_bytes[d] = alloc_depth_bytes[d];
+        }
+    }
+
+    void write(std::ostream &out) const
+    {
+        out << "Bot turn allocations: " << alloc_count - count << " (" << alloc_bytes - bytes
+            << " bytes), peak live memory: " << alloc_peak << " bytes\n";
+        bool any = false;
+        for (int d = 0; d < Alloc_depths; ++d)
+        {
+            const size_t n = alloc_depth_count[d] - depth_count[d];
+            if (!n)
+                continue;
+            out << (any ? ", " : "  ");
+            any = true;
+            if (d == 0)
+                out << "outside search";
+            else
+                out << "depth " << d - 1 << (d == Alloc_depths - 1 ? "+" : "");
+            out << ": " << n << " (" << alloc_depth_bytes[d] - depth_bytes[d] << " bytes)";
+        }
+        if (any)
+            out << "\n";
+    }
+
+  private:
+    size_t count, bytes;
+    size_t depth_count[Alloc_depths], depth_bytes[Alloc_depths];
+};
+
+#define ALLOC_DEPTH_SCOPE(depth) Alloc_depth_scope alloc_depth_scope_(int(depth))
+#endif
+
+void *operator new(size_t size)
+{
+    ++alloc_count;
+    ++alloc_thread_count;
+#ifdef CHECKERS_ALLOC_PROFILE
+    char *block = static_cast<char *>(std::malloc(size + Alloc_header));
+    if (!block)
+        throw std::bad_alloc();
+    *reinterpret_cast<size_t *>(block) = size;
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    alloc_depth_count[alloc_depth].fetch_add(1, std::memory_order_relaxed);
+    alloc_depth_bytes[alloc_depth].fetch_add(size, std::memory_order_relaxed);
+    const size_t live = alloc_live.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = alloc_peak.load(std::memory_order_relaxed);
+    while (live > peak && !alloc_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+    return block + Alloc_header;
+#else
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+#endif
+}
+
+void operator delete(void *ptr) noexcept
+{
+#ifdef CHECKERS_ALLOC_PROFILE
+    if (!ptr)
+        return;
+    char *block = static_cast<char *>(ptr) - Alloc_header;
+    alloc_live.fetch_sub(*reinterpret_cast<size_t *>(block), std::memory_order_relaxed);
+    std::free(block);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+#endif
+
+#ifndef CHECKERS_ALLOC_PROFILE
+#define ALLOC_DEPTH_SCOPE(depth)
+#endif
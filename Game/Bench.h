@@ -0,0 +1,428 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Geometry.h"
+#include "Leaf_eval.h"
+#include "Logic.h"
+#include "Mcts.h"
+#include "Perf_counters.h"
+
+// Детерминированный бенчмарк поиска.
+// Ищет лучший ход во встроенном наборе позиций на фиксированную глубину с фиксированным зерном
+// генератора и выводит суммарное количество узлов (сигнатуру), время и скорость поиска.
+// Любое изменение поведения поиска меняет сигнатуру, поэтому её удобно сравнивать между сборками.
+class Bench
+{
+  public:
+    // Запускает бенчмарк. Если expected_nodes не 0, сверяет с ним сигнатуру.
+    // Возвращает код завершения: 0 - успех, 1 - сигнатура не совпала, 2 - поиск не нашёл хода
+    int run(const size_t expected_nodes = 0) const
+    {
+        size_t total_nodes = 0;
+        bool search_failed = false;
+        Perf_counters counters;
+        auto start = chrono::steady_clock::now();
+        counters.start();
+
+        const size_t count = size(positions) + size(international_positions);
+        size_t num = 0;
+        for (const auto &pos : positions)
+            search<Logic>(pos, ++num, count, total_nodes, search_failed);
+        for (const auto &pos : international_positions)
+            search<International_logic>(pos, ++num, count, total_nodes, search_failed);
+
+        counters.stop();
+        auto end = chrono::steady_clock::now();
+        const double ms = max(1.0, chrono::duration<double, milli>(end - start).count());
+        cout << "===========================\n";
+        cout << "Total time (ms) : " << (long long)ms << "\n";
+        cout << "Nodes searched  : " << total_nodes << "\n";
+        cout << "Nodes/second    : " << (long long)(total_nodes * 1000 / ms) << "\n";
+        counters.report(cout, double(total_nodes), "node");
+        cout.flush();
+
+        if (search_failed)
+            return 2;
+        if (expected_nodes && expected_nodes != total_nodes)
+        {
+            cout << "Signature mismatch, expected " << expected_nodes << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Бенчмарк генерации ходов: perft - число позиций на глубине Perft_depth полных ходов (серия взятий -
+    // один ход) из каждой позиции набора. Число позиций не зависит от порядка ходов, поэтому служит
+    // сигнатурой генератора. Печатает время, ходы в секунду и аппаратные счётчики на сгенерированный ход
+    int run_movegen() const
+    {
+        size_t leaves = 0, moves = 0;
+        Perf_counters counters;
+        auto start = chrono::steady_clock::now();
+        counters.start();
+        for (const auto &pos : positions)
+        {
+            Logic logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+            leaves += perft(logic, parse<8>(pos.rows), pos.color, Perft_depth, moves);
+        }
+        for (const auto &pos : international_positions)
+        {
+            International_logic logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+            leaves += perft(logic, parse<10>(pos.rows), pos.color, Perft_depth - 1, moves);
+        }
+        counters.stop();
+        const double ms = ms_since(start);
+        const bool rules_ok = check_rules_fixtures();
+        cout << "Perft leaves    : " << leaves << "\n";
+        cout << "Moves generated : " << moves << "\n";
+        cout << "Total time (ms) : " << (long long)ms << "\n";
+        cout << "Moves/second    : " << (long long)(moves * 1000 / ms) << "\n";
+        counters.report(cout, double(moves), "move");
+        cout.flush();
+        return rules_ok ? 0 : 1;
+    }
+
+    // Микробенчмарк оценки листьев: скалярная оценка по клеткам против пачечной векторной (Leaf_eval)
+    // на группах соседних листьев - позициях после всех ответов на каждый ход в позициях набора.
+    // Выводит число оценок в секунду для обоих путей. Возвращает 1, если оценки разошлись
+    int run_eval() const
+    {
+        vector<board_mtx> leaves;
+        vector<size_t> group_end;  // Конец каждой группы соседей в leaves
+        Logic logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+        for (const auto &pos : positions)
+        {
+            const board_mtx root = parse<8>(pos.rows);
+            logic.find_turns(pos.color, root);
+            const move_list root_turns = logic.turns;
+            for (const auto &turn : root_turns)
+            {
+                const board_mtx child = Logic::make_turn(root, turn);
+                logic.find_turns(!pos.color, child);
+                for (const auto &reply : logic.turns)
+                    leaves.push_back(Logic::make_turn(child, reply));
+                if (group_end.empty() || group_end.back() != leaves.size())
+                    group_end.push_back(leaves.size());
+            }
+        }
+
+        // Повторяем набор, пока не наберётся Eval_count оценок на каждый путь
+        const size_t rounds = Eval_count / leaves.size() + 1;
+        vector<double> scalar(leaves.size()), batched(leaves.size());
+        auto start = chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t k = 0; k < leaves.size(); ++k)
+                scalar[k] = Leaf_eval<8>::score_scalar(leaves[k], Scoring::NumberAndPotential, r % 2);
+        const double scalar_ms = ms_since(start);
+
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            size_t begin = 0;
+            for (const size_t end : group_end)
+            {
+                Leaf_eval<8>::score_batch(&leaves[begin], end - begin, Scoring::NumberAndPotential, r % 2,
+                                          &batched[begin]);
+                begin = end;
+            }
+        }
+        const double batched_ms = ms_since(start);
+
+        const double evals = double(rounds * leaves.size());
+        cout << "Leaf positions  : " << leaves.size() << " in " << group_end.size() << " sibling groups\n";
+        cout << "SIMD            : " << Leaf_eval<8>::Simd << "\n";
+        cout << "Scalar evals/s  : " << (long long)(evals * 1000 / scalar_ms) << "\n";
+        cout << "Batched evals/s : " << (long long)(evals * 1000 / batched_ms) << " (x" << scalar_ms / batched_ms
+             << ")" << endl;
+        if (scalar != batched)
+        {
+            cout << "Batched scores differ from scalar ones" << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Сравнение MCTS с альфа-бета поиском при равном времени на ход.
+    // Сначала печатает число доигрываний MCTS в секунду из начальной позиции для 1, 2, 4 ... threads потоков,
+    // затем играет games партий MCTS (threads потоков) против альфа-бета поиска с итеративным углублением,
+    // меняя цвета. Обоим даётся ms миллисекунд на ход; альфа-бета поиск однопоточный, его уровень растёт,
+    // пока не кончится время. Возвращает 2, если движок не нашёл хода
+    int run_mcts(const int games, const unsigned ms, size_t threads) const
+    {
+        threads = max<size_t>(threads ? threads : thread::hardware_concurrency(), 1);
+        const board_mtx start_mtx = parse<8>(positions[0].rows);
+        const chrono::milliseconds time(ms);
+        cout << "MCTS scaling from the start position, " << ms << " ms per search\n";
+        double single = 0;
+        for (size_t t = 1;; t = min(t * 2, threads))
+        {
+            Mcts mcts(Mcts_bench_mb, t, 0);
+            mcts.find_best_turns(start_mtx, 0, time);
+            const double rate = mcts.playouts * 1000.0 / ms;
+            if (t == 1)
+                single = rate;
+            cout << "Threads " << t << " : " << (long long)rate << " playouts/s (x" << rate / single << ")\n";
+            if (t == threads)
+                break;
+        }
+
+        int score[3] = {0, 0, 0};  // Победы MCTS, победы альфа-бета, ничьи
+        long long depth_sum = 0, ab_moves = 0;
+        for (int g = 0; g < games; ++g)
+        {
+            const bool mcts_color = (g % 2);
+            Mcts mcts(Mcts_bench_mb, threads, unsigned(g));
+            Logic logic(Scoring::NumberAndPotential, Optimization::O1, unsigned(g));
+            board_mtx mtx = start_mtx;
+            int winner = -1;
+            for (int ply = 0; ply < Mcts_bench_plies; ++ply)
+            {
+                const bool side = (ply % 2);
+                logic.find_turns(side, mtx);
+                if (logic.turns.empty())
+                {
+                    winner = !side;
+                    break;
+                }
+                vector<move_pos> turns;
+                if (side == mcts_color)
+                    turns = mcts.find_best_turns(mtx, side, time);
+                else
+                {
+                    turns = timed_search(logic, mtx, side, time, depth_sum);
+                    ++ab_moves;
+                }
+                if (turns.empty() || turns[0].x == -1)
+                    return 2;
+                mtx = Logic::apply_chain(mtx, turns);
+            }
+            ++score[winner == -1 ? 2 : (winner == int(mcts_color) ? 0 : 1)];
+            cout << "Game " << g + 1 << "/" << games << ": MCTS (" << (mcts_color ? "black" : "white") << ") "
+                 << (winner == -1 ? "draw" : (winner == int(mcts_color) ? "win" : "loss")) << "\n";
+        }
+        cout << "===========================\n";
+        cout << "MCTS threads    : " << threads << "\n";
+        cout << "Alpha-beta level: " << (ab_moves ? double(depth_sum) / ab_moves : 0) << " on average\n";
+        cout << "MCTS +" << score[0] << " -" << score[1] << " =" << score[2] << endl;
+        return 0;
+    }
+
+  private:
+    static constexpr size_t Mcts_bench_mb = 256;  // Память дерева MCTS в сравнении
+    static constexpr int Mcts_bench_plies = 120;  // После стольких полуходов партия - ничья, как MaxNumTurns
+
+    // Итеративное углубление альфа-бета поиска, пока не выйдет время: возвращает ход последнего
+    // завершённого уровня и прибавляет этот уровень к depth_sum
+    static vector<move_pos> timed_search(Logic &logic, const board_mtx &mtx, const bool color,
+                                         const chrono::milliseconds time, long long &depth_sum)
+    {
+        atomic<bool> stop{false};
+        mutex m;
+        condition_variable cv;
+        bool finished = false;
+        thread timer([&] {
+            unique_lock<mutex> lock(m);
+            if (!cv.wait_for(lock, time, [&] { return finished; }))
+                stop = true;
+        });
+        vector<move_pos> best;
+        int level = 0;
+        for (; level <= Max_bench_level; ++level)
+        {
+            // Уровень 0 доводится до конца, чтобы всегда был ход
+            logic.stop_flag = (level ? &stop : nullptr);
+            logic.Max_depth = level;
+            auto turns = logic.find_best_turns(mtx, color);
+            if (logic.stopped())
+                break;
+            best = turns;
+        }
+        logic.stop_flag = nullptr;
+        depth_sum += level - 1;
+        {
+            lock_guard<mutex> lock(m);
+            finished = true;
+        }
+        cv.notify_one();
+        timer.join();
+        return best;
+    }
+
+    static constexpr int Max_bench_level = 30;
+    static constexpr int Perft_depth = 7;  // Глубина perft в полных ходах (для 10x10 на один меньше)
+
+    // Число позиций на глубине depth полных ходов стороны color и далее по очереди, moves - счётчик ходов
+    template <class L> static size_t perft(L &logic, const typename L::board_mtx &mtx, const bool color,
+                                           const int depth, size_t &moves)
+    {
+        if (depth == 0)
+            return 1;
+        logic.find_turns(color, mtx);
+        moves += logic.turns.size();
+        const move_list turns = logic.turns;
+        const bool beats = logic.have_beats;
+        size_t leaves = 0;
+        for (const auto &turn : turns)
+        {
+            if (beats)
+                leaves += perft_capture(logic, L::make_turn(mtx, turn), color, turn.x2, turn.y2, depth, moves);
+            else
+                leaves += perft(logic, L::make_turn(mtx, turn), !color, depth - 1, moves);
+        }
+        return leaves;
+    }
+
+    // Продолжение серии взятий фигурой на (x, y) в perft
+    template <class L>
+    static size_t perft_capture(L &logic, const typename L::board_mtx &mtx, const bool color, const POS_T x,
+                                const POS_T y, const int depth, size_t &moves)
+    {
+        logic.find_captures(x, y, mtx);
+        if (!logic.have_beats)
+            return perft(logic, mtx, !color, depth - 1, moves);
+        moves += logic.turns.size();
+        const move_list turns = logic.turns;
+        size_t leaves = 0;
+        for (const auto &turn : turns)
+            leaves += perft_capture(logic, L::make_turn(mtx, turn), color, turn.x2, turn.y2, depth, moves);
+        return leaves;
+    }
+    // Сверяет число полных ходов и длину самой длинной серии в позициях rules_fixtures, печатает расхождения
+    static bool check_rules_fixtures()
+    {
+        bool ok = true;
+        for (const auto &f : rules_fixtures)
+        {
+            International_logic logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+            vector<vector<move_pos>> chains;
+            logic.collect_chains(parse<10>(f.rows), f.color, chains);
+            size_t longest = 0;
+            for (const auto &chain : chains)
+                longest = max(longest, chain.size());
+            if (chains.size() != f.moves || longest != f.longest)
+            {
+                cout << "Rules fixture \"" << f.name << "\": " << chains.size() << " moves, longest series " << longest
+                     << ", expected " << f.moves << " and " << f.longest << "\n";
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    static constexpr size_t Eval_count = 20000000;  // Оценок на путь в микробенчмарке оценки
+
+    static double ms_since(const chrono::steady_clock::time_point start)
+    {
+        return max(1e-3, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Позиция набора для доски N x N: строки доски сверху вниз, цвет ходящей стороны и уровень бота
+    // Обозначения: w/b - белая/чёрная фигура, W/B - белая/чёрная дамка, '.' - пустая клетка
+    template <int N> struct basic_bench_position
+    {
+        const char *rows[N];
+        bool color;  // 0 - ходят белые, 1 - чёрные
+        int depth;
+    };
+    typedef basic_bench_position<8> bench_position;
+
+    // Поиск в одной позиции набора по правилам L
+    template <class L>
+    static void search(const basic_bench_position<L::Geometry::Size> &pos, const size_t num, const size_t count,
+                       size_t &total_nodes, bool &search_failed)
+    {
+        // Новый Logic для каждой позиции, чтобы порядок ходов не зависел от предыдущих
+        L logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+        logic.Max_depth = pos.depth;
+        auto turns = logic.find_best_turns(parse<L::Geometry::Size>(pos.rows), pos.color);
+        if (turns.empty() || turns[0].x == -1)
+            search_failed = true;
+        total_nodes += logic.nodes;
+        cout << "Position " << num << "/" << count << ": " << logic.nodes << " nodes\n";
+    }
+
+    // Преобразует текстовое описание позиции в матрицу доски
+    template <int N> static basic_board_mtx<N> parse(const char *const (&rows)[N])
+    {
+        basic_board_mtx<N> mtx{};
+        for (POS_T i = 0; i < N; ++i)
+        {
+            for (POS_T j = 0; j < N; ++j)
+            {
+                switch (rows[i][j])
+                {
+                case 'w':
+                    mtx[i][j] = 1;
+                    break;
+                case 'b':
+                    mtx[i][j] = 2;
+                    break;
+                case 'W':
+                    mtx[i][j] = 3;
+                    break;
+                case 'B':
+                    mtx[i][j] = 4;
+                    break;
+                }
+            }
+        }
+        return mtx;
+    }
+
+    static constexpr bench_position positions[] = {
+        // Начальная позиция
+        {{".b.b.b.b", "b.b.b.b.", ".b.b.b.b", "........", "........", "w.w.w.w.", ".w.w.w.w", "w.w.w.w."}, 0, 9},
+        {{".b.b.b.b", "b.b.b.b.", ".b.b.b.b", "........", "........", "w.w.w.w.", ".w.w.w.w", "w.w.w.w."}, 1, 8},
+        // Миттельшпиль
+        {{".b.b.b.b", "b.b...b.", "...b.b.b", "..b.w...", ".w.w....", "w...w.w.", ".w.w.w.w", "w.w.w.w."}, 1, 9},
+        {{".b...b.b", "b...b...", ".b.b...b", "..b.....", ".w...w..", "..w.w...", ".w...w.w", "w.w....."}, 0, 9},
+        // Серии взятий
+        {{"........", "........", ".b.b.b..", "........", ".b.b.b..", "w.w.....", "........", "..W....."}, 0, 9},
+        // Эндшпиль с дамками
+        {{"........", "..B.....", "........", "....w...", "...b....", "........", ".W...w..", "........"}, 0, 10},
+        {{"...B....", "........", ".....b..", "........", "........", "..W.....", "........", ".....W.."}, 1, 9},
+    };
+
+    // Международные шашки 10x10
+    static constexpr basic_bench_position<10> international_positions[] = {
+        // Начальная позиция
+        {{".b.b.b.b.b", "b.b.b.b.b.", ".b.b.b.b.b", "b.b.b.b.b.", "..........", "..........", ".w.w.w.w.w",
+          "w.w.w.w.w.", ".w.w.w.w.w", "w.w.w.w.w."},
+         0, 7},
+        // Выбор серии с наибольшим числом взятий
+        {{"..........", "..........", "...b......", "..........", "...b.b....", "..........", "...b.b....",
+          "....w.....", "..........", ".W........"},
+         0, 7},
+    };
+
+    // Позиция 10x10 с известным числом полных ходов и длиной самой длинной серии взятий
+    struct rules_fixture
+    {
+        const char *name;
+        const char *rows[10];
+        bool color;
+        size_t moves;
+        size_t longest;
+    };
+    static constexpr rules_fixture rules_fixtures[] = {
+        // Взятая шашка стоит на доске до конца серии: дамка не может пройти через неё обратно
+        // и взять вторую шашку на той же диагонали
+        {"king blocked by taken piece",
+         {"..........", "..b.......", "...W......", "..........", "..........", "..........", ".......b..",
+          "..........", ".b........", ".........."},
+         0, 3, 1},
+        // Простая, закончившая серию на последней горизонтали, становится дамкой только после хода
+        {"man promotes after the series",
+         {"...b......", "......B...", "...B.w....", "..........", "...b......", "....B.....", "..........",
+          "b.........", "..........", "........b."},
+         0, 1, 1},
+    };
+};
+
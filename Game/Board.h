@@ -1,10 +1,18 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "../Models/Move.h"
 #include "../Models/Project_path.h"
+#include "Snapshot_exchange.h"
+#include "Trace.h"
 
 #ifdef __APPLE__
     #include <SDL2/SDL.h>
@@ -16,18 +24,34 @@
 
 using namespace std;
 
+// Замеры цикла окна для бенчмарка отрисовки, в микросекундах.
+// Пишет только цикл окна (run), читать их можно после его завершения
+struct render_timings
+{
+    vector<float> frame;    // Кадр без ожидания: сборка вершин, отрисовка и показ
+    vector<float> present;  // SDL_RenderPresent
+    vector<float> resize;   // Пересчёт размеров и разметки после изменения окна
+    float atlas_load = 0;   // Загрузка картинок и сборка атласа
+};
+
 // Класс для работы с игровой доской
+// Все вызовы SDL для окна, рендерера и событий делаются только в главном потоке: он крутит цикл
+// окна (run), а игровая логика и поиск идут в своём потоке (поток игры). Изменения доски
+// не рисуются сразу: каждое публикует неизменяемый снимок состояния через Snapshot_exchange,
+// и цикл окна с частотой кадров экрана рисует самый свежий снимок, плавно анимируя последний ход.
+// События окна цикл перекладывает в очередь, откуда их забирает поток игры (poll_event, wait_event).
+// Поэтому игровая логика и поиск никогда не ждут видеокарту и смену кадров.
 class Board
 {
 public:
     Board() = default;
 
     // Конструктор для создания доски с заданной шириной (W) и высотой (H)
-    Board(const unsigned int W, const unsigned int H) : W(W), H(H)
+    Board(const unsigned int W, const unsigned int H) : W(int(W)), H(int(H))
     {
     }
 
-    // Рисует начальное состояние доски (создаёт окно и загружает текстуры)
+    // Рисует начальное состояние доски (создаёт окно, рендерер и атлас). Вызывается в главном потоке
     int start_draw()
     {
         if (SDL_Init(SDL_INIT_EVERYTHING) != 0)  // Инициализация SDL
@@ -45,7 +69,7 @@ public:
             }
             W = min(dm.w, dm.h);  // Устанавливаем размер окна в зависимости от разрешения экрана
             W -= W / 15;  // Уменьшаем размер для создания отступов
-            H = W;  // Ширина и высота одинаковые для квадратной доски
+            H = W.load();  // Ширина и высота одинаковые для квадратной доски
         }
 
         // Создаём окно и рендерер для отрисовки
@@ -62,34 +86,105 @@ public:
             print_exception("SDL_CreateRenderer can't create renderer");
             return 1;
         }
+        // Собираем все картинки в один атлас, чтобы кадр рисовался одним вызовом
+        const auto atlas_start = chrono::steady_clock::now();
+        const int atlas_failed = load_atlas();
+        if (timings)
+            timings->atlas_load = micros_since(atlas_start);
+        if (atlas_failed)
+            return 1;
+        update_size();  // Получаем фактические размеры окна
 
-        // Загружаем текстуры для доски, фигур, кнопок и результата
-        board = IMG_LoadTexture(ren, board_path.c_str());
-        w_piece = IMG_LoadTexture(ren, piece_white_path.c_str());
-        b_piece = IMG_LoadTexture(ren, piece_black_path.c_str());
-        w_queen = IMG_LoadTexture(ren, queen_white_path.c_str());
-        b_queen = IMG_LoadTexture(ren, queen_black_path.c_str());
-        back = IMG_LoadTexture(ren, back_path.c_str());
-        replay = IMG_LoadTexture(ren, replay_path.c_str());
+        make_start_mtx();  // Инициализируем начальную матрицу фигур
+        publish();  // Первый кадр уже будет с доской
+        return 0;
+    }
 
-        if (!board || !w_piece || !b_piece || !w_queen || !b_queen || !back || !replay)
+    // Цикл окна в главном потоке: разбирает события SDL и рисует самый свежий снимок каждый кадр,
+    // пока поток игры не вызовет stop. Темп задаёт вертикальная синхронизация, без неё кадры
+    // ограничиваются Frame_time
+    void run()
+    {
+        while (!stop_render)
         {
-            print_exception("IMG_LoadTexture can't load main textures from " + textures_path);
-            return 1;
+            const auto frame_start = chrono::steady_clock::now();
+            pump_events();
+            if (size_request.exchange(false))
+            {
+                SDL_SetWindowSize(win, requested_w, requested_h);
+                resized = true;
+            }
+            if (resized.exchange(false))
+            {
+                update_size();
+                if (timings)
+                    timings->resize.push_back(micros_since(frame_start));
+            }
+            snapshots.take();
+            render_frame(snapshots.front(), frame_start);
+            {
+                TRACE_SCOPE("Board::present");
+                const auto present_start = chrono::steady_clock::now();
+                SDL_RenderPresent(ren);
+                if (timings)
+                {
+                    timings->present.push_back(micros_since(present_start));
+                    timings->frame.push_back(micros_since(frame_start));
+                }
+            }
+            const auto spent = chrono::steady_clock::now() - frame_start;
+            if (spent < Frame_time)
+            {
+                TRACE_SCOPE("Board::frame_delay");
+                this_thread::sleep_for(Frame_time - spent);
+            }
         }
+    }
 
-        SDL_GetRendererOutputSize(ren, &W, &H);  // Получаем фактические размеры окна
-        make_start_mtx();  // Инициализируем начальную матрицу фигур
-        rerender();  // Перерисовываем доску
-        return 0;
+    // Завершает цикл окна (вызывается потоком игры, когда игра окончена)
+    void stop()
+    {
+        {
+            lock_guard<mutex> lock(events_mtx);
+            stop_render = true;
+        }
+        events_cv.notify_all();
+    }
+
+    // Забирает событие окна из очереди, не дожидаясь новых. Возвращает false, если событий нет
+    bool poll_event(SDL_Event &event)
+    {
+        lock_guard<mutex> lock(events_mtx);
+        if (events.empty())
+            return false;
+        event = events.front();
+        events.pop_front();
+        return true;
+    }
+
+    // Ждёт следующее событие окна и всегда возвращает true. Если цикл окна уже остановлен, событие - SDL_QUIT
+    bool wait_event(SDL_Event &event)
+    {
+        unique_lock<mutex> lock(events_mtx);
+        events_cv.wait(lock, [this] { return stop_render || !events.empty(); });
+        if (events.empty())
+        {
+            event.type = SDL_QUIT;
+            return true;
+        }
+        event = events.front();
+        events.pop_front();
+        return true;
     }
 
     // Перерисовывает доску, очищая её и сбрасывая все состояния
     void redraw()
     {
         game_results = -1;
+        progress = -1;
         history_mtx.clear();
         history_beat_series.clear();
+        anim.seq = 0;  // Анимация старого хода больше не нужна
         make_start_mtx();  // Восстанавливаем начальное состояние
         clear_active();  // Убираем подсвеченную клетку
         clear_highlight();  // Убираем подсветку возможных ходов
@@ -98,6 +193,7 @@ public:
     // Выполняет перемещение фигуры на доске
     void move_piece(move_pos turn, const int beat_series = 0)
     {
+        add_hop(turn, beat_series);  // Запоминаем прыжок для анимации
         if (turn.xb != -1)  // Если фигура была побеждена
         {
             mtx[turn.xb][turn.yb] = 0;  // Убираем побеждённую фигуру с доски
@@ -128,7 +224,7 @@ public:
     void drop_piece(const POS_T i, const POS_T j)
     {
         mtx[i][j] = 0;
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Преобразует фигуру в дамку
@@ -139,7 +235,7 @@ public:
             throw runtime_error("can't turn into queen in this position");
         }
         mtx[i][j] += 2;  // Преобразуем фигуру в дамку
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Возвращает текущую матрицу доски
@@ -156,7 +252,7 @@ public:
             POS_T x = pos.first, y = pos.second;
             is_highlighted_[x][y] = 1;  // Устанавливаем подсветку для клеток
         }
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Очищает подсветку всех клеток
@@ -166,7 +262,7 @@ public:
         {
             is_highlighted_[i].assign(8, 0);  // Сбрасываем подсветку
         }
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Устанавливает активную клетку (клетка, на которую можно переместить фигуру)
@@ -174,7 +270,7 @@ public:
     {
         active_x = x;
         active_y = y;
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Очищает активную клетку
@@ -182,7 +278,7 @@ public:
     {
         active_x = -1;
         active_y = -1;
-        rerender();  // Перерисовываем доску
+        publish();  // Перерисовываем доску
     }
 
     // Проверяет, подсвечена ли клетка
@@ -191,6 +287,23 @@ public:
         return is_highlighted_[x][y];
     }
 
+    // Восстанавливает партию по истории досок и серий взятий (последняя доска - текущая)
+    void restore(const vector<vector<vector<POS_T>>> &history, const vector<int> &beat_series)
+    {
+        history_mtx = history;
+        history_beat_series = beat_series;
+        mtx = history_mtx.back();
+        anim.seq = 0;  // Восстановленную позицию не анимируем
+        clear_highlight();
+        clear_active();
+    }
+
+    // Серии взятий для досок истории
+    const vector<int> &beat_history() const
+    {
+        return history_beat_series;
+    }
+
     // Откатывает последние ходы
     void rollback()
     {
@@ -201,6 +314,7 @@ public:
             history_beat_series.pop_back();
         }
         mtx = *(history_mtx.rbegin());  // Восстанавливаем доску
+        anim.seq = 0;  // Отменённый ход не анимируем
         clear_highlight();  // Очищаем подсветку
         clear_active();  // Очищаем активную клетку
     }
@@ -209,28 +323,38 @@ public:
     void show_final(const int res)
     {
         game_results = res;
-        rerender();  // Перерисовываем доску для отображения результата
+        publish();  // Перерисовываем доску для отображения результата
+    }
+
+    // Показывает полосу хода поиска бота: доля от 0 до 1, отрицательное значение скрывает полосу
+    void show_progress(const double fraction)
+    {
+        progress = fraction;
+        publish();  // Перерисовываем доску
+    }
+
+    // Меняет размер окна из программы (для бенчмарка отрисовки), окно меняет цикл окна перед следующим кадром
+    void set_window_size(const int w, const int h)
+    {
+        requested_w = w;
+        requested_h = h;
+        size_request = true;
     }
 
     // Функция для изменения размера окна, если он был изменён
+    // Новые размеры и разметку цикл окна берёт перед следующим кадром
     void reset_window_size()
     {
-        SDL_GetRendererOutputSize(ren, &W, &H);  // Получаем новые размеры
-        rerender();  // Перерисовываем доску
+        resized = true;
     }
 
-    // Закрытие всех ресурсов SDL
+    // Закрытие всех ресурсов SDL (в главном потоке, после завершения цикла окна)
     void quit()
     {
-        SDL_DestroyTexture(board);
-        SDL_DestroyTexture(w_piece);
-        SDL_DestroyTexture(b_piece);
-        SDL_DestroyTexture(w_queen);
-        SDL_DestroyTexture(b_queen);
-        SDL_DestroyTexture(back);
-        SDL_DestroyTexture(replay);
+        SDL_DestroyTexture(atlas);
         SDL_DestroyRenderer(ren);
         SDL_DestroyWindow(win);
+        win = nullptr;
         SDL_Quit();
     }
 
@@ -242,6 +366,31 @@ public:
     }
 
 private:
+    // Последний ход для анимации: фигура и её прыжки (для серии взятий - все удары подряд)
+    static constexpr int Max_hops = 16;
+    struct move_animation
+    {
+        unsigned seq = 0;  // Номер хода, 0 - анимировать нечего
+        POS_T type = 0;    // Тип фигуры до хода
+        int hops = 0;
+        struct
+        {
+            POS_T x, y, x2, y2, xb, yb;
+            POS_T beaten;  // Тип побитой фигуры, 0 - тихий ход
+        } hop[Max_hops];
+    };
+
+    // Снимок всего, что нужно для кадра
+    struct board_snapshot
+    {
+        POS_T mtx[8][8];
+        bool highlighted[8][8];
+        int active_x = -1, active_y = -1;
+        int game_results = -1;
+        double progress = -1;
+        move_animation anim;
+    };
+
     // Добавление хода в историю
     void add_history(const int beat_series = 0)
     {
@@ -266,99 +415,265 @@ private:
         add_history();  // Добавляем начальную матрицу в историю
     }
 
-    // Функция для перерисовки всех текстур
-    void rerender()
+    // Загружает картинки из Textures и упаковывает их в один атлас (каждую - в свою ячейку Atlas_cells)
+    int load_atlas()
     {
-        // Очистка экрана
-        SDL_RenderClear(ren);
-        SDL_RenderCopy(ren, board, NULL, NULL);
+        TRACE_SCOPE("Board::load_textures");
+        SDL_Surface *pack = SDL_CreateRGBSurfaceWithFormat(0, Atlas_w, Atlas_h, 32, SDL_PIXELFORMAT_RGBA32);
+        if (pack == nullptr)
+        {
+            print_exception("SDL_CreateRGBSurfaceWithFormat can't create texture atlas");
+            return 1;
+        }
+        SDL_FillRect(pack, nullptr, SDL_MapRGBA(pack->format, 0, 0, 0, 0));
+        for (int i = 0; i < Pictures; ++i)
+        {
+            const string path = textures_path + picture_files[i];
+            SDL_Surface *img = IMG_Load(path.c_str());
+            SDL_Surface *rgba = img ? SDL_ConvertSurfaceFormat(img, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+            // Масштабируем с линейной интерполяцией, копируя и альфа-канал
+            const bool ok = rgba && SDL_SoftStretchLinear(rgba, nullptr, pack, &Atlas_cells[i]) == 0;
+            SDL_FreeSurface(rgba);
+            SDL_FreeSurface(img);
+            if (!ok)
+            {
+                SDL_FreeSurface(pack);
+                print_exception("IMG_Load can't load texture " + path);
+                return 1;
+            }
+        }
+        // Белый квадрат для заливки подсветки и полосы поиска нужным цветом
+        SDL_FillRect(pack, &Atlas_cells[Pixel], SDL_MapRGBA(pack->format, 255, 255, 255, 255));
+
+        atlas = SDL_CreateTextureFromSurface(ren, pack);
+        SDL_FreeSurface(pack);
+        if (atlas == nullptr)
+        {
+            print_exception("SDL_CreateTextureFromSurface can't create texture atlas");
+            return 1;
+        }
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        vertices.reserve(4 * 512);  // Запас на доску, фигуры и рамки подсветки всех клеток
+        indices.reserve(6 * 512);
+        return 0;
+    }
+
+    // Пересчитывает прямоугольники всех элементов под текущий размер окна
+    void update_layout()
+    {
+        layout.board = {0, 0, float(W), float(H)};
+        for (int k = 0; k < 8; ++k)
+        {
+            // Клетка k-го столбца/строки занимает десятую часть окна с отступом в одну клетку
+            layout.cell_x[k] = float(W * (k + 1) / 10);
+            layout.cell_y[k] = float(H * (k + 1) / 10);
+            layout.piece_x[k] = float(W * (k + 1) / 10 + W / 120);
+            layout.piece_y[k] = float(H * (k + 1) / 10 + H / 120);
+        }
+        layout.cell_w = float(W / 10);
+        layout.cell_h = float(H / 10);
+        layout.piece_w = float(W / 12);
+        layout.piece_h = float(H / 12);
+        layout.back = {float(W / 40), float(H / 40), float(W / 15), float(H / 15)};
+        layout.replay = {float(W * 109 / 120), float(H / 40), float(W / 15), float(H / 15)};
+        layout.result = {float(W / 5), float(H * 3 / 10), float(W * 3 / 5), float(H * 2 / 5)};
+        layout.progress = {float(W / 10), float(H * 37 / 40), float(W * 8 / 10), float(H / 80)};
+    }
+
+    // Добавляет в пакет кадра прямоугольник dst с картинкой атласа pic, окрашенный в color
+    void add_quad(const int pic, const SDL_FRect &dst, const SDL_Color color = {255, 255, 255, 255})
+    {
+        const SDL_Rect &src = Atlas_cells[pic];
+        float u0 = float(src.x) / Atlas_w, v0 = float(src.y) / Atlas_h;
+        float u1 = float(src.x + src.w) / Atlas_w, v1 = float(src.y + src.h) / Atlas_h;
+        if (pic == Pixel)
+        {
+            // Сплошная заливка берётся из центра белого квадрата, чтобы фильтрация не захватила соседей
+            u0 = u1 = (u0 + u1) / 2;
+            v0 = v1 = (v0 + v1) / 2;
+        }
+        const int base = int(vertices.size());
+        vertices.push_back({{dst.x, dst.y}, color, {u0, v0}});
+        vertices.push_back({{dst.x + dst.w, dst.y}, color, {u1, v0}});
+        vertices.push_back({{dst.x + dst.w, dst.y + dst.h}, color, {u1, v1}});
+        vertices.push_back({{dst.x, dst.y + dst.h}, color, {u0, v1}});
+        for (const int k : {0, 1, 2, 0, 2, 3})
+            indices.push_back(base + k);
+    }
+
+    // Рамка клетки толщиной Frame_width из четырёх полос
+    void add_frame(const SDL_FRect &r, const SDL_Color color)
+    {
+        add_quad(Pixel, {r.x, r.y, r.w, Frame_width}, color);
+        add_quad(Pixel, {r.x, r.y + r.h - Frame_width, r.w, Frame_width}, color);
+        add_quad(Pixel, {r.x, r.y, Frame_width, r.h}, color);
+        add_quad(Pixel, {r.x + r.w - Frame_width, r.y, Frame_width, r.h}, color);
+    }
+
+    // Добавляет прыжок в анимацию хода. Первый прыжок (или тихий ход) начинает новый ход,
+    // следующие удары серии дописываются к нему
+    void add_hop(const move_pos &turn, const int beat_series)
+    {
+        if (beat_series <= 1 || anim.seq == 0 || anim.hops == Max_hops)
+        {
+            anim.seq = ++anim_counter;
+            anim.hops = 0;
+            anim.type = mtx[turn.x][turn.y];
+        }
+        const POS_T beaten = (turn.xb != -1 ? mtx[turn.xb][turn.yb] : 0);
+        anim.hop[anim.hops++] = {turn.x, turn.y, turn.x2, turn.y2, turn.xb, turn.yb, beaten};
+    }
+
+    // Публикует снимок текущего состояния для цикла окна. Не ждёт кадра и не выделяет память
+    void publish()
+    {
+        TRACE_SCOPE("Board::publish");
+        board_snapshot &snap = snapshots.back();
+        for (POS_T i = 0; i < 8; ++i)
+        {
+            for (POS_T j = 0; j < 8; ++j)
+            {
+                snap.mtx[i][j] = mtx[i][j];
+                snap.highlighted[i][j] = is_highlighted_[i][j];
+            }
+        }
+        snap.active_x = active_x;
+        snap.active_y = active_y;
+        snap.game_results = game_results;
+        snap.progress = progress;
+        snap.anim = anim;
+        snapshots.publish();
+    }
+
+    // Перекладывает события SDL в очередь потока игры. Изменение размера окна цикл окна учитывает сам
+    void pump_events()
+    {
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                resized = true;
+            {
+                lock_guard<mutex> lock(events_mtx);
+                events.push_back(event);
+            }
+            events_cv.notify_one();
+        }
+    }
+
+    // Размеры окна и разметка (только в цикле окна)
+    void update_size()
+    {
+        int w, h;
+        SDL_GetRendererOutputSize(ren, &w, &h);
+        W = w;
+        H = h;
+        update_layout();  // Разметка пересчитывается только здесь, а не в каждом кадре
+    }
+
+    // Рисует кадр по снимку snap на момент now (показывает его run).
+    // Доска, фигуры, подсветка, кнопки и результат собираются в один пакет вершин
+    // и рисуются одним вызовом SDL_RenderGeometry из атласа
+    void render_frame(const board_snapshot &snap, const chrono::steady_clock::time_point now)
+    {
+        TRACE_SCOPE("Board::render_frame");
+        vertices.clear();  // Ёмкость сохраняется между кадрами
+        indices.clear();
+        add_quad(Board_picture, layout.board);
+
+        // Ход анимации: каждому новому прыжку отводится Hop_time после окончания предыдущего
+        const move_animation &a = snap.anim;
+        if (a.seq != anim_seen)
+        {
+            anim_seen = a.seq;
+            hops_seen = 0;
+        }
+        for (; hops_seen < a.hops; ++hops_seen)
+            hop_start[hops_seen] = (hops_seen ? max(now, hop_start[hops_seen - 1] + Hop_time) : now);
+        int hop = -1;  // Текущий прыжок
+        float t = 1;   // Доля пройденного пути в текущем прыжке
+        if (a.seq)
+        {
+            for (int k = 0; k < a.hops && hop_start[k] <= now; ++k)
+                hop = k;
+            if (hop != -1)
+                t = min(1.f, chrono::duration<float>(now - hop_start[hop]) / chrono::duration<float>(Hop_time));
+            if (hop == a.hops - 1 && t >= 1)
+                hop = -1;  // Анимация закончена
+        }
+        const auto &last = a.hop[max(a.hops - 1, 0)];
 
         // Отображение фигур
         for (POS_T i = 0; i < 8; ++i)
         {
             for (POS_T j = 0; j < 8; ++j)
             {
-                if (!mtx[i][j])  // Если клетка пустая, пропускаем
+                if (!snap.mtx[i][j])  // Если клетка пустая, пропускаем
                     continue;
-
-                // Вычисляем позицию фигуры на экране
-                int wpos = W * (j + 1) / 10 + W / 120;
-                int hpos = H * (i + 1) / 10 + H / 120;
-                SDL_Rect rect{ wpos, hpos, W / 12, H / 12 };
-
-                SDL_Texture* piece_texture;
-                // Выбираем текстуру в зависимости от типа фигуры
-                if (mtx[i][j] == 1)
-                    piece_texture = w_piece;
-                else if (mtx[i][j] == 2)
-                    piece_texture = b_piece;
-                else if (mtx[i][j] == 3)
-                    piece_texture = w_queen;
-                else
-                    piece_texture = b_queen;
-
-                SDL_RenderCopy(ren, piece_texture, NULL, &rect);  // Отображаем фигуру
+                if (hop != -1 && i == last.x2 && j == last.y2)
+                    continue;  // Фигура ещё в пути
+                // Картинки фигур в атласе идут в порядке типов: 1 - белая, 2 - чёрная, 3, 4 - дамки
+                add_quad(Piece_white + snap.mtx[i][j] - 1,
+                         {layout.piece_x[j], layout.piece_y[i], layout.piece_w, layout.piece_h});
+            }
+        }
+        if (hop != -1)
+        {
+            // Побитые фигуры пропадают, когда через них перепрыгнули
+            for (int k = hop; k < a.hops; ++k)
+            {
+                const auto &h = a.hop[k];
+                if (!h.beaten)
+                    continue;
+                const Uint8 alpha = Uint8(255 * (k == hop ? 1 - t : 1));
+                add_quad(Piece_white + h.beaten - 1, {layout.piece_x[h.yb], layout.piece_y[h.xb], layout.piece_w,
+                                                      layout.piece_h}, {255, 255, 255, alpha});
             }
+            const auto &h = a.hop[hop];
+            const float px = layout.piece_x[h.y] + (layout.piece_x[h.y2] - layout.piece_x[h.y]) * t;
+            const float py = layout.piece_y[h.x] + (layout.piece_y[h.x2] - layout.piece_y[h.x]) * t;
+            add_quad(Piece_white + a.type - 1, {px, py, layout.piece_w, layout.piece_h});
         }
 
         // Отображение подсветки
-        SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
-        const double scale = 2.5;
-        SDL_RenderSetScale(ren, scale, scale);
         for (POS_T i = 0; i < 8; ++i)
         {
             for (POS_T j = 0; j < 8; ++j)
             {
-                if (!is_highlighted_[i][j])
-                    continue;
-                SDL_Rect cell{ int(W * (j + 1) / 10 / scale), int(H * (i + 1) / 10 / scale), int(W / 10 / scale),
-                              int(H / 10 / scale) };
-                SDL_RenderDrawRect(ren, &cell);
+                if (snap.highlighted[i][j])
+                    add_frame({layout.cell_x[j], layout.cell_y[i], layout.cell_w, layout.cell_h}, {0, 255, 0, 255});
             }
         }
 
         // Отображение активной клетки
-        if (active_x != -1)
+        if (snap.active_x != -1)
+            add_frame({layout.cell_x[snap.active_y], layout.cell_y[snap.active_x], layout.cell_w, layout.cell_h},
+                      {255, 0, 0, 255});
+
+        // Отображение полосы хода поиска бота под доской
+        if (snap.progress >= 0)
         {
-            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
-            SDL_Rect active_cell{ int(W * (active_y + 1) / 10 / scale), int(H * (active_x + 1) / 10 / scale),
-                                 int(W / 10 / scale), int(H / 10 / scale) };
-            SDL_RenderDrawRect(ren, &active_cell);
+            SDL_FRect bar = layout.progress;
+            bar.w *= float(min(snap.progress, 1.0));
+            add_quad(Pixel, bar, {0, 255, 0, 255});
         }
-        SDL_RenderSetScale(ren, 1, 1);
 
         // Отображение кнопок
-        SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, back, NULL, &rect_left);
-        SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, replay, NULL, &replay_rect);
+        add_quad(Back_button, layout.back);
+        add_quad(Replay_button, layout.replay);
 
         // Отображение результата игры
-        if (game_results != -1)
-        {
-            string result_path = draw_path;
-            if (game_results == 1)
-                result_path = white_path;
-            else if (game_results == 2)
-                result_path = black_path;
-
-            SDL_Texture* result_texture = IMG_LoadTexture(ren, result_path.c_str());
-            if (result_texture == nullptr)
-            {
-                print_exception("IMG_LoadTexture can't load game result picture from " + result_path);
-                return;
-            }
+        if (snap.game_results != -1)
+            add_quad(snap.game_results == 1 ? White_wins : (snap.game_results == 2 ? Black_wins : Draw_result),
+                     layout.result);
 
-            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
-            SDL_RenderCopy(ren, result_texture, NULL, &res_rect);
-            SDL_DestroyTexture(result_texture);
-        }
+        SDL_RenderClear(ren);
+        SDL_RenderGeometry(ren, atlas, vertices.data(), int(vertices.size()), indices.data(), int(indices.size()));
+    }
 
-        SDL_RenderPresent(ren);
-        // Ожидаем перед следующими действиями
-        SDL_Delay(10);
-        SDL_Event windowEvent;
-        SDL_PollEvent(&windowEvent);
+    static float micros_since(const chrono::steady_clock::time_point start)
+    {
+        return chrono::duration<float, micro>(chrono::steady_clock::now() - start).count();
     }
 
     // Запись ошибки в лог
@@ -369,41 +684,104 @@ private:
     }
 
 public:
-    int W = 0;  // Ширина окна
-    int H = 0;  // Высота окна
+    // Размеры окна, обновляются циклом окна
+    atomic<int> W{0};  // Ширина окна
+    atomic<int> H{0};  // Высота окна
 
     // История состояний доски
     vector<vector<vector<POS_T>>> history_mtx;
 
+    // Замеры цикла окна (бенчмарк), задаются до start_draw; nullptr - не замерять
+    render_timings *timings = nullptr;
+
 private:
     SDL_Window *win = nullptr;  // Окно
     SDL_Renderer *ren = nullptr;  // Рендерер
-    // Текстуры для доски, фигур и кнопок
-    SDL_Texture *board = nullptr;
-    SDL_Texture *w_piece = nullptr;
-    SDL_Texture *b_piece = nullptr;
-    SDL_Texture *w_queen = nullptr;
-    SDL_Texture *b_queen = nullptr;
-    SDL_Texture *back = nullptr;
-    SDL_Texture *replay = nullptr;
-
-    // Пути к изображениям для текстур
+    // Картинки атласа, порядок фигур совпадает с их типами в матрице доски
+    enum Picture
+    {
+        Board_picture,
+        Piece_white,
+        Piece_black,
+        Queen_white,
+        Queen_black,
+        Back_button,
+        Replay_button,
+        White_wins,
+        Black_wins,
+        Draw_result,
+        Pictures,  // Количество картинок из файлов
+        Pixel = Pictures  // Белый квадрат для сплошной заливки
+    };
+    const char *const picture_files[Pictures] = {"board.png",     "piece_white.png", "piece_black.png", "queen_white.png",
+                                                 "queen_black.png", "back.png",     "replay.png",      "white_wins.png",
+                                                 "black_wins.png",  "draw.png"};
+    // Размер атласа и ячейки картинок в нём: доска в левом верхнем углу, справа от неё столбец фигур
+    // и кнопок, снизу ряд надписей результата. Атлас не больше 2048x2048 - предела размера текстуры
+    // у старых видеокарт и рендереров (SDL_RendererInfo::max_texture_width / max_texture_height)
+    static constexpr int Atlas_w = 2048, Atlas_h = 2048, Atlas_max = 2048;
+    static constexpr SDL_Rect Atlas_cells[Pictures + 1] = {
+        {0, 0, 1664, 1664},      {1664, 0, 256, 256},    {1664, 256, 256, 256},  {1664, 512, 256, 256},
+        {1664, 768, 256, 256},   {1664, 1024, 256, 256}, {1664, 1280, 256, 256}, {0, 1664, 640, 384},
+        {640, 1664, 640, 384},   {1280, 1664, 640, 384}, {1920, 0, 4, 4}};
+    static_assert(Atlas_w <= Atlas_max && Atlas_h <= Atlas_max, "atlas exceeds the texture size limit");
+    static_assert(
+        [] {
+            for (const SDL_Rect &r : Atlas_cells)
+            {
+                if (r.x < 0 || r.y < 0 || r.x + r.w > Atlas_w || r.y + r.h > Atlas_h)
+                    return false;
+            }
+            return true;
+        }(),
+        "atlas cell outside the atlas");
+    static constexpr float Frame_width = 2.5f;  // Толщина рамки подсветки
+
+    SDL_Texture *atlas = nullptr;  // Единая текстура со всеми картинками
+
+    // Разметка окна, пересчитывается в update_layout при изменении размера
+    struct
+    {
+        SDL_FRect board, back, replay, result, progress;
+        float cell_x[8], cell_y[8], cell_w, cell_h;     // Клетки (для подсветки)
+        float piece_x[8], piece_y[8], piece_w, piece_h;  // Фигуры внутри клеток
+    } layout{};
+
+    static constexpr chrono::milliseconds Hop_time{120};    // Длительность анимации одного прыжка
+    static constexpr chrono::milliseconds Frame_time{16};   // Минимальная длительность кадра без вертикальной синхронизации
+
+    // Состояние, общее для потоков
+    Snapshot_exchange<board_snapshot> snapshots;
+    atomic<bool> stop_render{false};
+    atomic<bool> resized{false};  // Размер окна изменился, разметку нужно пересчитать
+    atomic<bool> size_request{false};  // set_window_size ждёт изменения окна
+    atomic<int> requested_w{0}, requested_h{0};
+    mutex events_mtx;  // Защищает events и ожидание stop_render
+    condition_variable events_cv;
+    deque<SDL_Event> events;  // События окна для потока игры
+
+    // Анимация хода, которую собирает поток игры
+    move_animation anim;
+    unsigned anim_counter = 0;
+
+    // Анимация, которую проигрывает цикл окна
+    unsigned anim_seen = 0;
+    int hops_seen = 0;
+    chrono::steady_clock::time_point hop_start[Max_hops];
+
+    // Пакет вершин кадра, переиспользуется между кадрами
+    vector<SDL_Vertex> vertices;
+    vector<int> indices;
+
+    // Путь к изображениям для текстур
     const string textures_path = project_path + "Textures/";
-    const string board_path = textures_path + "board.png";
-    const string piece_white_path = textures_path + "piece_white.png";
-    const string piece_black_path = textures_path + "piece_black.png";
-    const string queen_white_path = textures_path + "queen_white.png";
-    const string queen_black_path = textures_path + "queen_black.png";
-    const string white_path = textures_path + "white_wins.png";
-    const string black_path = textures_path + "black_wins.png";
-    const string draw_path = textures_path + "draw.png";
-    const string back_path = textures_path + "back.png";
-    const string replay_path = textures_path + "replay.png";
 
     // Координаты активной клетки
     int active_x = -1, active_y = -1;
     // Результат игры
     int game_results = -1;
+    // Доля хода поиска бота (-1, если бот не думает)
+    double progress = -1;
     // Матрица подсвеченных клеток
     vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(8, vector<bool>(8, 0));
     // Матрица для хранения состояния доски (фигуры, пустые клетки)
@@ -1,11 +1,29 @@
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#else
+    #include <filesystem>
+#endif
+
 #include "../Models/Project_path.h"
+#include "../Models/Settings.h"
 
-// Класс для работы с настройками игры, загружаемыми из JSON-файла
+// Класс для работы с настройками игры, загружаемыми из JSON-файла.
+// Файл разбирается один раз в неизменяемый снимок Settings. Отдельный поток следит за изменением
+// settings.json (inotify на Linux, время изменения файла на других системах) и атомарно подменяет снимок,
+// поэтому уровни бота и задержку можно менять без перезапуска игры и без REPLAY.
 class Config
 {
   public:
@@ -13,25 +31,167 @@ class Config
     Config()
     {
         reload();
+        watcher = std::thread(&Config::watch, this);
+    }
+
+    Config(const Config &) = delete;
+    Config &operator=(const Config &) = delete;
+
+    ~Config()
+    {
+        stop_watching = true;
+        watcher.join();
     }
 
     // Функция для перезагрузки конфигурации из файла settings.json
-    // Открывает файл, читает JSON-данные и сохраняет их в объект config
-    void reload()
+    // При ошибке в файле пишет её в лог и оставляет прежний снимок
+    bool reload()
+    {
+        try
+        {
+            std::atomic_store(&snapshot, std::make_shared<const Settings>(load()));
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            std::ofstream fout(project_path + "log.txt", std::ios_base::app);
+            fout << "Error: can't load settings.json. " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    // Текущий снимок настроек. Снимок не меняется, поэтому его можно использовать весь ход,
+    // а новые значения из файла подхватываются при следующем вызове
+    std::shared_ptr<const Settings> get() const
+    {
+        return std::atomic_load(&snapshot);
+    }
+
+  private:
+    // Читает и проверяет settings.json, бросает исключение при ошибке
+    static Settings load()
     {
-        // Открываем файл настроек
         std::ifstream fin(project_path + "settings.json");
-        fin >> config;   // Загружаем содержимое файла в объект config
-        fin.close();     // Закрываем файл
+        if (!fin)
+            throw std::runtime_error("file not found");
+        // Файл настроек содержит комментарии, поэтому разрешаем их при разборе
+        const json config = json::parse(fin, nullptr, true, true);
+
+        Settings s;
+        s.width = config.at("WindowSize").at("Width").get<unsigned>();
+        s.height = config.at("WindowSize").at("Hight").get<unsigned>();
+
+        const json &bot = config.at("Bot");
+        s.is_bot[0] = bot.at("IsWhiteBot").get<bool>();
+        s.is_bot[1] = bot.at("IsBlackBot").get<bool>();
+        s.bot_level[0] = bot.at("WhiteBotLevel").get<int>();
+        s.bot_level[1] = bot.at("BlackBotLevel").get<int>();
+        if (s.bot_level[0] < 0 || s.bot_level[1] < 0)
+            throw std::runtime_error("bot level must be non-negative");
+        s.delay_ms = bot.at("BotDelayMS").get<unsigned>();
+        s.no_random = bot.at("NoRandom").get<bool>();
+
+        const std::string scoring = bot.at("BotScoringType").get<std::string>();
+        if (scoring == "NumberOnly")
+            s.scoring = Scoring::NumberOnly;
+        else if (scoring == "NumberAndPotential")
+            s.scoring = Scoring::NumberAndPotential;
+        else
+            throw std::runtime_error("unknown BotScoringType " + scoring);
+
+        const std::string optimization = bot.at("Optimization").get<std::string>();
+        if (optimization == "O0")
+            s.optimization = Optimization::O0;
+        else if (optimization == "O1")
+            s.optimization = Optimization::O1;
+        else if (optimization == "O2")
+            s.optimization = Optimization::O2;
+        else
+            throw std::runtime_error("unknown Optimization " + optimization);
+
+        // Необязательные поля: старые файлы настроек без них остаются рабочими
+        s.cache_file = bot.value("CacheFile", std::string());
+        s.cache_mb = bot.value("CacheMB", 64u);
+        if (!s.cache_file.empty() && s.cache_mb == 0)
+            throw std::runtime_error("CacheMB must be positive");
+        s.solver_mb = bot.value("SolverMB", 4u);
+        const char *engine_keys[2] = {"WhiteBotEngine", "BlackBotEngine"};
+        for (int color = 0; color < 2; ++color)
+        {
+            const std::string engine = bot.value(engine_keys[color], std::string("AlphaBeta"));
+            if (engine == "AlphaBeta")
+                s.engine[color] = Bot_engine::AlphaBeta;
+            else if (engine == "MCTS")
+                s.engine[color] = Bot_engine::MCTS;
+            else
+                throw std::runtime_error("unknown " + std::string(engine_keys[color]) + " " + engine);
+        }
+        s.mcts_time_ms = bot.value("MctsTimeMS", 1000u);
+        s.mcts_threads = bot.value("MctsThreads", 0u);
+        s.mcts_mb = bot.value("MctsMB", 64u);
+        if (s.mcts_time_ms == 0 || s.mcts_mb == 0)
+            throw std::runtime_error("MctsTimeMS and MctsMB must be positive");
+
+        s.max_turns = config.at("Game").at("MaxNumTurns").get<int>();
+        s.save_file = config.at("Game").value("SaveFile", std::string());
+        return s;
     }
 
-    // Оператор вызова для доступа к данным конфигурации
-    // Позволяет обратиться к настройке по пути и имени
-    auto operator()(const string &setting_dir, const string &setting_name) const
+    // Поток наблюдения за файлом настроек
+    void watch()
     {
-        return config[setting_dir][setting_name];  // Возвращаем значение, найденное в JSON
+#ifdef __linux__
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+            return;
+        // Следим за каталогом: редакторы часто сохраняют файл через переименование
+        const std::string dir = project_path.empty() ? std::string(".") : project_path;
+        if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(fd);
+            return;
+        }
+        alignas(inotify_event) char buf[4096];
+        while (!stop_watching)
+        {
+            pollfd pfd{fd, POLLIN, 0};
+            if (poll(&pfd, 1, Watch_period_ms) <= 0)
+                continue;
+            const ssize_t len = read(fd, buf, sizeof(buf));
+            bool changed = false;
+            for (char *ptr = buf; ptr < buf + len;)
+            {
+                const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                if (event->len && std::string(event->name) == "settings.json")
+                    changed = true;
+                ptr += sizeof(inotify_event) + event->len;
+            }
+            if (changed)
+                reload();
+        }
+        close(fd);
+#else
+        namespace fs = std::filesystem;
+        const fs::path path = project_path + "settings.json";
+        std::error_code ec;
+        auto last_write = fs::last_write_time(path, ec);
+        while (!stop_watching)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Watch_period_ms));
+            const auto cur_write = fs::last_write_time(path, ec);
+            if (!ec && cur_write != last_write)
+            {
+                last_write = cur_write;
+                reload();
+            }
+        }
+#endif
     }
 
   private:
-    json config;  // Объект для хранения данных конфигурации в формате JSON
+    static constexpr int Watch_period_ms = 100;  // Период проверки флага остановки / времени изменения файла
+
+    std::shared_ptr<const Settings> snapshot = std::make_shared<const Settings>();  // Текущий снимок настроек
+    std::atomic<bool> stop_watching{false};
+    std::thread watcher;  // Поток наблюдения за settings.json
 };
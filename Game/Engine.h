@@ -0,0 +1,260 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Geometry.h"
+#include "Logic.h"
+#include "Trace.h"
+
+// Консольный движок без окна: построчный текстовый протокол через stdin/stdout.
+// Команды:
+//   position startpos                  - начальная позиция, ходят белые
+//   position <32 клетки> <w|b>         - клетки в порядке индексов Geometry ('.', w, b, W, B) и сторона хода
+//   go [depth N] [movetime MS] [ponder] [multipv K]
+//                                      - поиск в фоне с итеративным углублением до уровня N,
+//                                        multipv K - анализ K лучших ходов с оценками
+//   stop                               - прервать поиск и сразу выдать лучший найденный ход
+//   ponderhit                          - соперник сделал ожидаемый ход, отсчёт movetime начинается сейчас
+//   isready                            - ответ readyok
+//   quit                               - выход
+// Во время поиска печатаются строки info, в конце - bestmove в нотации c3-d4 или c3:e5:c7 для взятий.
+class Engine
+{
+  public:
+    // cache_file - необязательный файл долговременной таблицы транспозиций размером cache_mb
+    explicit Engine(const string &cache_file = string(), const size_t cache_mb = 64)
+        : logic(Scoring::NumberAndPotential, Optimization::O1, 0), mtx(Logic::start_mtx())
+    {
+        if (!cache_file.empty())
+        {
+            cache = make_unique<Transposition_table>(cache_file, cache_mb);
+            if (!cache->persistent())
+                say("info string can't map " + cache_file + ", cache is in memory only");
+            logic.tt = cache.get();
+        }
+    }
+
+    ~Engine()
+    {
+        stop_search();
+    }
+
+    // Главный цикл: читает команды, пока не придёт quit или не закончится ввод
+    int loop()
+    {
+        string line;
+        while (getline(cin, line))
+        {
+            istringstream in(line);
+            string cmd;
+            in >> cmd;
+            if (cmd == "quit")
+                break;
+            if (cmd == "isready")
+                say("readyok");
+            else if (cmd == "position")
+            {
+                stop_search();
+                if (!set_position(in))
+                    say("info string bad position");
+            }
+            else if (cmd == "go")
+                go(in);
+            else if (cmd == "stop")
+                stop_search();
+            else if (cmd == "ponderhit")
+                ponderhit();
+            else if (!cmd.empty())
+                say("info string unknown command " + cmd);
+        }
+        stop_search();
+        return 0;
+    }
+
+  private:
+    // Разбор команды position
+    bool set_position(istringstream &in)
+    {
+        string cells, side;
+        in >> cells;
+        if (cells == "startpos")
+        {
+            mtx = Logic::start_mtx();
+            color = 0;
+            return true;
+        }
+        in >> side;
+        if (cells.size() != Geometry::Cells || (side != "w" && side != "b"))
+            return false;
+        board_mtx res{};
+        for (int idx = 0; idx < Geometry::Cells; ++idx)
+        {
+            const string types = ".wbWB";
+            const auto type = types.find(cells[idx]);
+            if (type == string::npos)
+                return false;
+            res[geometry.cell[idx].x][geometry.cell[idx].y] = POS_T(type);
+        }
+        mtx = res;
+        color = (side == "b");
+        return true;
+    }
+
+    // Разбор команды go и запуск поиска в отдельном потоке
+    void go(istringstream &in)
+    {
+        stop_search();
+        int max_level = Max_level;
+        long long movetime = -1;
+        bool ponder = false;
+        size_t multipv = 1;
+        string token;
+        while (in >> token)
+        {
+            if (token == "depth")
+                in >> max_level;
+            else if (token == "movetime")
+                in >> movetime;
+            else if (token == "ponder")
+                ponder = true;
+            else if (token == "multipv")
+                in >> multipv;
+        }
+
+        stop = false;
+        finished = false;
+        pondering = ponder;
+        searcher = thread(&Engine::search, this, mtx, color, max_level, multipv);
+        timer = thread(&Engine::watch_time, this, movetime);
+    }
+
+    // Останавливает текущий поиск и дожидается выдачи bestmove
+    void stop_search()
+    {
+        {
+            lock_guard<mutex> lock(state_mtx);
+            stop = true;
+            pondering = false;
+        }
+        state_cv.notify_all();
+        if (searcher.joinable())
+            searcher.join();
+        if (timer.joinable())
+            timer.join();
+    }
+
+    void ponderhit()
+    {
+        {
+            lock_guard<mutex> lock(state_mtx);
+            pondering = false;
+        }
+        state_cv.notify_all();
+    }
+
+    // Поток контроля времени: после окончания ponder ждёт movetime и останавливает поиск
+    void watch_time(const long long movetime)
+    {
+        unique_lock<mutex> lock(state_mtx);
+        state_cv.wait(lock, [this] { return !pondering || finished; });
+        if (movetime < 0)
+            return;
+        const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(movetime);
+        if (!state_cv.wait_until(lock, deadline, [this] { return finished.load(); }))
+            stop = true;
+    }
+
+    // Итеративное углубление: уровни 0..max_level, прерванная итерация отбрасывается.
+    // При multipv > 1 на каждом уровне печатается по строке info на каждую из лучших линий
+    void search(const board_mtx pos, const bool side, const int max_level, const size_t multipv)
+    {
+        const auto start = chrono::steady_clock::now();
+        vector<move_pos> best;
+        size_t total_nodes = 0;
+        for (int level = 0; level <= max_level; ++level)
+        {
+            TRACE_SCOPE("Engine::iteration");
+            // Уровень 0 доводится до конца, чтобы всегда был ход для ответа
+            logic.stop_flag = (level ? &stop : nullptr);
+            logic.Max_depth = level;
+            vector<pv_line> lines;
+            if (multipv > 1)
+                lines = logic.find_best_lines(pos, side, multipv);
+            else
+                lines.push_back({0, {logic.find_best_turns(pos, side)}});
+            total_nodes += logic.nodes;
+            if (logic.stopped() || lines.empty() || lines[0].pv[0].empty() || lines[0].pv[0][0].x == -1)
+                break;
+            best = lines[0].pv[0];
+
+            const auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+            for (size_t i = 0; i < lines.size(); ++i)
+            {
+                ostringstream info;
+                info << "info depth " << level;
+                if (multipv > 1)
+                    info << " multipv " << i + 1;
+                info << " score " << fixed << setprecision(3) << (multipv > 1 ? lines[i].score : logic.score)
+                     << " nodes " << total_nodes << " time " << ms << " nps "
+                     << total_nodes * 1000 / max<long long>(ms, 1) << " pv ";
+                for (size_t j = 0; j < lines[i].pv.size(); ++j)
+                    info << (j ? " " : "") << notation(lines[i].pv[j]);
+                say(info.str());
+            }
+        }
+        logic.stop_flag = nullptr;
+
+        // Во время ponder ход выдаётся только после ponderhit или stop
+        unique_lock<mutex> lock(state_mtx);
+        state_cv.wait(lock, [this] { return !pondering; });
+        say("bestmove " + (best.empty() ? string("none") : notation(best)));
+        finished = true;
+        lock.unlock();
+        state_cv.notify_all();
+    }
+
+    // Запись цепочки ходов: c3-d4 для тихого хода, c3:e5:c7 для серии взятий
+    static string notation(const vector<move_pos> &turns)
+    {
+        string res = square(turns[0].x, turns[0].y);
+        for (const auto &turn : turns)
+            res += (turn.xb != -1 ? ":" : "-") + square(turn.x2, turn.y2);
+        return res;
+    }
+
+    static string square(const POS_T x, const POS_T y)
+    {
+        return string(1, char('a' + y)) + to_string(Geometry::Size - x);
+    }
+
+    // Потокобезопасный вывод строки протокола
+    void say(const string &text)
+    {
+        lock_guard<mutex> lock(out_mtx);
+        cout << text << endl;
+    }
+
+  private:
+    static constexpr int Max_level = 64;  // Уровень по умолчанию для go без depth
+
+    Logic logic;
+    unique_ptr<Transposition_table> cache;  // Таблица транспозиций в файле (может отсутствовать)
+    board_mtx mtx;   // Текущая позиция
+    bool color = 0;  // Сторона хода: 0 - белые, 1 - чёрные
+
+    thread searcher;  // Поток поиска
+    thread timer;     // Поток контроля времени
+    atomic<bool> stop{false};
+    atomic<bool> finished{false};
+    bool pondering = false;  // Защищён state_mtx
+    mutex state_mtx;
+    condition_variable state_cv;
+    mutex out_mtx;
+};
@@ -1,12 +1,17 @@
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <thread>
 
 #include "../Models/Project_path.h"
 #include "Board.h"
 #include "Config.h"
+#include "Game_snapshot.h"
 #include "Hand.h"
 #include "Logic.h"
+#include "Mcts.h"
+#include "Trace.h"
 
 // Класс для управления игрой в шашки
 class Game
@@ -14,46 +19,88 @@ class Game
   public:
     // Конструктор класса Game
     // Инициализирует объекты board, hand и logic с настройками из конфигурации
-    Game() : board(config("WindowSize", "Width"), config("WindowSize", "Hight")), hand(&board), logic(&board, &config)
+    Game() : board(config.get()->width, config.get()->height), hand(&board), logic(&board, &config)
     {
         ofstream fout(project_path + "log.txt", ios_base::trunc);  // Создаёт новый файл для логирования
-        fout.close();  // Закрывает файл сразу после создания
+        // Долговременная таблица транспозиций открывается один раз и переживает REPLAY и перезапуски
+        const auto settings = config.get();
+        if (!settings->cache_file.empty())
+        {
+            cache = make_unique<Transposition_table>(project_path + settings->cache_file, settings->cache_mb);
+            if (!cache->persistent())
+                fout << "Error: can't map search cache " << settings->cache_file << ", using memory only\n";
+            else if (cache->recovered_after_crash())
+                fout << "Search cache " << settings->cache_file << " was not closed cleanly, damaged entries are skipped\n";
+            logic.tt = cache.get();
+        }
+        if (!settings->save_file.empty())
+            save_path = project_path + settings->save_file;
+#ifdef CHECKERS_TREE_CAPTURE
+        tree_capture = make_unique<Tree_capture>(project_path + "search_tree.bin", Logic::Geometry::Size);
+        logic.tree = tree_capture.get();
+#endif
+        fout.close();  // Закрывает файл
     }
 
-    // Основная функция для начала игры
-    // В этой функции запускается игровой цикл, обрабатываются ходы игроков и бота
+    // Основная функция для начала игры, вызывается в главном потоке.
+    // Главный поток создаёт окно и крутит его цикл (Board::run): все вызовы SDL для окна и отрисовки
+    // остаются в нём, а партии с ходами игроков и бота играются в отдельном потоке игры
     int play()
     {
+        if (board.start_draw())  // Инициализируем доску
+            return 1;
+        int res = 0;
+        thread game_thread([this, &res] {
+            res = play_games();
+            board.stop();  // Игра окончена, цикл окна завершается
+        });
+        board.run();
+        game_thread.join();
+        return res;
+    }
+
+  private:
+    // Игровой цикл (в потоке игры): обрабатываются ходы игроков и бота
+    int play_games()
+    {
+        TRACE_SCOPE("Game::play");
         auto start = chrono::steady_clock::now();  // Засекаем время начала игры
 
         // Если игра начинается заново (replay), перезагружаем конфигурацию и перерисовываем доску
         if (is_replay)
         {
-            logic = Logic(&board, &config);  // Перезапускаем логику игры
             config.reload();  // Перезагружаем настройки
+            logic = Logic(&board, &config);  // Перезапускаем логику игры
+            logic.tt = cache.get();  // Накопленные результаты поиска остаются доступны
+#ifdef CHECKERS_TREE_CAPTURE
+            logic.tree = tree_capture.get();
+#endif
+            mcts[0].reset();  // Деревья MCTS создаются заново с новыми MctsThreads / MctsMB
+            mcts[1].reset();
             board.redraw();  // Перерисовываем игровую доску
         }
-        else
-        {
-            board.start_draw();  // Инициализируем доску для новой игры
-        }
-        is_replay = false;
 
         int turn_num = -1;  // Номер хода
         bool is_quit = false;  // Флаг выхода из игры
-        const int Max_turns = config("Game", "MaxNumTurns");  // Максимальное количество ходов, заданное в конфигурации
+        const int Max_turns = config.get()->max_turns;  // Максимальное количество ходов, заданное в конфигурации
+        if (!is_replay)
+            turn_num = resume_game();  // Продолжаем сохранённую партию, если она есть
+        is_replay = false;
 
         // Игровой цикл
         while (++turn_num < Max_turns)
         {
             beat_series = 0;  // Сброс серии побеждённых фигур
+            // Снимок настроек на этот ход: изменения settings.json подхватываются между ходами
+            const auto settings = config.get();
+            save_game(turn_num, *settings);  // Снимок партии перед каждым ходом
             logic.find_turns(turn_num % 2);  // Находим доступные ходы для текущего игрока (0 — белые, 1 — чёрные)
             if (logic.turns.empty())  // Если нет доступных ходов, игра заканчивается
                 break;
 
             // Настройка уровня сложности бота в зависимости от цвета
-            logic.Max_depth = config("Bot", string((turn_num % 2) ? "Black" : "White") + string("BotLevel"));
-            if (!config("Bot", string("Is") + string((turn_num % 2) ? "Black" : "White") + string("Bot")))  // Если это не бот
+            logic.Max_depth = settings->bot_level[turn_num % 2];
+            if (!settings->is_bot[turn_num % 2])  // Если это не бот
             {
                 auto resp = player_turn(turn_num % 2);  // Ход игрока
                 if (resp == Response::QUIT)  // Если игрок решил выйти
@@ -68,7 +115,7 @@ class Game
                 }
                 else if (resp == Response::BACK)  // Если игрок хочет откатить ход
                 {
-                    if (config("Bot", string("Is") + string((1 - turn_num % 2) ? "Black" : "White") + string("Bot")) &&
+                    if (settings->is_bot[1 - turn_num % 2] &&
                         !beat_series && board.history_mtx.size() > 2)
                     {
                         board.rollback();  // Откат хода
@@ -83,7 +130,28 @@ class Game
                 }
             }
             else  // Если ходит бот
-                bot_turn(turn_num % 2);
+            {
+                auto resp = bot_turn(turn_num % 2);  // Ход бота, пока он думает, окно обрабатывает нажатия
+                if (resp == Response::QUIT)
+                {
+                    is_quit = true;
+                    break;
+                }
+                else if (resp == Response::REPLAY)
+                {
+                    is_replay = true;
+                    break;
+                }
+                else if (resp == Response::BACK)  // Поиск отменён, право хода возвращается предыдущему игроку
+                {
+                    if (board.history_mtx.size() > 1)
+                    {
+                        board.rollback();  // Откат хода
+                        --turn_num;
+                    }
+                    --turn_num;
+                }
+            }
         }
 
         auto end = chrono::steady_clock::now();  // Засекаем время окончания игры
@@ -92,9 +160,16 @@ class Game
         fout.close();
 
         if (is_replay)  // Если игра перезапускается
-            return play();
+            return play_games();
         if (is_quit)  // Если игрок вышел из игры
+        {
+            // Партия сохраняется на начало текущего хода, незаконченная серия взятий не попадает в снимок
+            if (!save_path.empty() && !Game_snapshot::save(save_path, last_save))
+                log_error("Error: can't write game snapshot " + save_path);
             return 0;
+        }
+        if (!save_path.empty())
+            Game_snapshot::remove(save_path);  // Законченную партию продолжать не нужно
 
         int res = 2;  // Изначально считаем ничью
         if (turn_num == Max_turns)  // Если превысили максимальное количество ходов
@@ -110,21 +185,143 @@ class Game
         if (resp == Response::REPLAY)  // Если игрок хочет перезапустить
         {
             is_replay = true;
-            return play();
+            return play_games();
         }
         return res;  // Возвращаем результат игры
     }
 
-  private:
+    // Загружает снимок партии из SaveFile и восстанавливает доску, если партия с теми же ролями, настройками ботов
+    // и лимитом ходов. Возвращает номер хода, с которого продолжить, минус один (как начальный -1 игрового цикла)
+    int resume_game()
+    {
+        saved_game saved;
+        const auto settings = config.get();
+        if (save_path.empty() || !Game_snapshot::load(save_path, saved))
+            return -1;
+        if (saved.max_turns != settings->max_turns || saved.turn_num >= settings->max_turns)
+            return -1;  // Снимок другой конфигурации: начинаем новую партию
+        for (int color = 0; color < 2; ++color)
+        {
+            if (saved.is_bot[color] != settings->is_bot[color])
+                return -1;
+            // Бот продолжает партию с тем же уровнем и движком, иначе партия начинается заново
+            if (saved.is_bot[color] && (saved.bot_level[color] != settings->bot_level[color] ||
+                                        saved.engine[color] != settings->engine[color] ||
+                                        saved.scoring != settings->scoring ||
+                                        saved.optimization != settings->optimization))
+                return -1;
+        }
+        // Номер хода должен совпадать с историей, иначе после восстановления ходила бы не та сторона.
+        // Доска истории добавляется на каждый удар серии, новый ход начинается доской с серией 0 или 1
+        int history_turns = 0;
+        for (size_t k = 1; k < saved.beat_series.size(); ++k)
+            history_turns += (saved.beat_series[k] <= 1);
+        if (history_turns != saved.turn_num)
+            return -1;
+        board.restore(saved.history, saved.beat_series);
+        logic.set_random_state(saved.random_state);
+        ofstream fout(project_path + "log.txt", ios_base::app);
+        fout << "Resumed saved game at turn " << saved.turn_num << "\n";
+        return saved.turn_num - 1;
+    }
+
+    // Пишет снимок партии перед ходом turn_num
+    void save_game(const int turn_num, const Settings &settings)
+    {
+        if (save_path.empty())
+            return;
+        TRACE_SCOPE("Game::save");
+        last_save.turn_num = turn_num;
+        last_save.max_turns = settings.max_turns;
+        for (int color = 0; color < 2; ++color)
+        {
+            last_save.is_bot[color] = settings.is_bot[color];
+            last_save.bot_level[color] = settings.bot_level[color];
+            last_save.engine[color] = settings.engine[color];
+        }
+        last_save.scoring = settings.scoring;
+        last_save.optimization = settings.optimization;
+        last_save.random_state = logic.random_state();
+        last_save.history = board.history_mtx;
+        last_save.beat_series = board.beat_history();
+        if (!Game_snapshot::save(save_path, last_save))
+            log_error("Error: can't write game snapshot " + save_path);
+    }
+
+    void log_error(const string &message)
+    {
+        ofstream fout(project_path + "log.txt", ios_base::app);
+        fout << message << "\n";
+    }
+
     // Функция для хода бота
-    void bot_turn(const bool color)
+    // Поиск идёт в отдельном потоке, а поток игры продолжает обрабатывать события окна и показывает
+    // полосу хода поиска. BACK, REPLAY и закрытие окна отменяют поиск через stop_flag за несколько миллисекунд.
+    // Возвращает OK, если ход сделан, иначе нажатую кнопку
+    Response bot_turn(const bool color)
     {
+        TRACE_SCOPE("Game::bot_turn");
         auto start = chrono::steady_clock::now();  // Засекаем время хода бота
+#ifdef CHECKERS_ALLOC_PROFILE
+        const Alloc_profile alloc_profile;  // Выделения памяти за ход, пишутся в лог вместе со временем
+#endif
 
-        auto delay_ms = config("Bot", "BotDelayMS");  // Задержка между ходами бота (если есть)
-        thread th(SDL_Delay, delay_ms);  // Поток для задержки, чтобы не блокировать основной процесс
-        auto turns = logic.find_best_turns(color);  // Находим лучший ход для бота
-        th.join();  // Ждём окончания потока
+        const auto settings = config.get();
+        const Uint32 delay_ms = settings->delay_ms;  // Задержка между ходами бота (если есть)
+        const size_t root_turns = logic.turns.size();  // Ходы корня уже найдены в игровом цикле
+        // Бот MCTS думает заданное время, его полоса поиска показывает прошедшую долю времени
+        const bool use_mcts = (settings->engine[color] == Bot_engine::MCTS);
+        const chrono::milliseconds mcts_time(settings->mcts_time_ms);
+        if (use_mcts && !mcts[color])
+            mcts[color] = make_unique<Mcts>(settings->mcts_mb, settings->mcts_threads,
+                                            settings->no_random ? 0u : unsigned(time(0)) + color);
+        vector<move_pos> turns;
+        bot_stop = false;
+        bot_progress = 0;
+        logic.stop_flag = &bot_stop;
+        logic.root_progress = &bot_progress;
+        if (use_mcts)
+            mcts[color]->stop_flag = &bot_stop;
+        atomic<bool> search_done{false};
+        thread searcher([this, color, use_mcts, mcts_time, &turns, &search_done] {
+            TRACE_SCOPE("Game::bot_search");
+            if (use_mcts)
+                turns = mcts[color]->find_best_turns(Logic::to_mtx(board.get_board()), color, mcts_time);
+            else
+                turns = logic.find_best_turns(color);  // Находим лучший ход для бота
+            search_done = true;
+        });
+
+        // Ждём окончания поиска и минимальной задержки, не переставая обрабатывать события
+        Response resp = Response::OK;
+        size_t shown = size_t(-1);
+        while (true)
+        {
+            resp = hand.poll();
+            if (resp != Response::OK)
+                bot_stop = true;  // Прерываем поиск, его результат не нужен
+            if (resp != Response::OK ||
+                (search_done && chrono::steady_clock::now() - start >= chrono::milliseconds(delay_ms)))
+                break;
+            const size_t done = use_mcts ? size_t(100 * (chrono::steady_clock::now() - start) / mcts_time)
+                                         : bot_progress.load(memory_order_relaxed);
+            if (done != shown)
+            {
+                shown = done;
+                // Перерисовка с задержкой до следующего кадра
+                board.show_progress(use_mcts ? min(done, size_t(100)) / 100.0 : double(done) / root_turns);
+            }
+            else
+                SDL_Delay(5);
+        }
+        searcher.join();
+        logic.stop_flag = nullptr;
+        logic.root_progress = nullptr;
+        if (use_mcts)
+            mcts[color]->stop_flag = nullptr;
+        board.show_progress(-1);
+        if (resp != Response::OK)
+            return resp;
 
         bool is_first = true;  // Флаг для первого хода
         // Выполнение ходов бота
@@ -132,7 +329,11 @@ class Game
         {
             if (!is_first)
             {
-                SDL_Delay(delay_ms);  // Задержка между ходами
+                resp = wait_events(delay_ms);  // Задержка между ходами
+                if (resp == Response::BACK)
+                    board.rollback();  // Откатываем уже сделанную часть серии
+                if (resp != Response::OK)
+                    return resp;
             }
             is_first = false;
             beat_series += (turn.xb != -1);  // Увеличиваем серию побеждённых фигур
@@ -140,14 +341,34 @@ class Game
         }
 
         auto end = chrono::steady_clock::now();  // Засекаем время окончания хода бота
+        TRACE_SCOPE("Game::write_log");
         ofstream fout(project_path + "log.txt", ios_base::app);  // Логируем время хода
         fout << "Bot turn time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
+#ifdef CHECKERS_ALLOC_PROFILE
+        alloc_profile.write(fout);
+#endif
         fout.close();
+        return Response::OK;
+    }
+
+    // Ждёт delay_ms, обрабатывая события окна. Возвращает OK или нажатую за это время кнопку
+    Response wait_events(const Uint32 delay_ms)
+    {
+        const auto until = chrono::steady_clock::now() + chrono::milliseconds(delay_ms);
+        while (chrono::steady_clock::now() < until)
+        {
+            auto resp = hand.poll();
+            if (resp != Response::OK)
+                return resp;
+            SDL_Delay(5);
+        }
+        return Response::OK;
     }
 
     // Функция для хода игрока
     Response player_turn(const bool color)
     {
+        TRACE_SCOPE("Game::player_turn");
         // Возвращает 1, если игрок решил выйти
         vector<pair<POS_T, POS_T>> cells;
         for (auto turn : logic.turns)
@@ -267,6 +488,15 @@ class Game
     Board board;  // Игровая доска
     Hand hand;  // Объект для взаимодействия с игроком (например, для ввода хода)
     Logic logic;  // Логика игры (поиск ходов, определение побед)
+    unique_ptr<Transposition_table> cache;  // Таблица транспозиций в файле (CacheFile), может отсутствовать
+    string save_path;  // Файл снимка партии (SaveFile), пустая строка - партия не сохраняется
+    saved_game last_save;  // Последний записанный снимок (на начало текущего хода)
+#ifdef CHECKERS_TREE_CAPTURE
+    unique_ptr<Tree_capture> tree_capture;  // Запись деревьев поиска бота в search_tree.bin
+#endif
+    unique_ptr<Mcts> mcts[2];  // Боты MCTS по цветам, создаются при первом ходе с движком MCTS
     int beat_series;  // Счётчик ударов
     bool is_replay = false;  // Флаг перезапуска игры
+    atomic<bool> bot_stop{false};  // Отмена поиска бота
+    atomic<size_t> bot_progress{0};  // Сколько ходов корня бот уже просмотрел
 };
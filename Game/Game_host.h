@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "../Models/Settings.h"
+#include "Geometry.h"
+#include "Logic.h"
+#include "Thread_pool.h"
+#include "Transposition_table.h"
+
+// Сводка задержек ответа бота (от запроса хода до применения ответа), в миллисекундах
+struct latency_stats
+{
+    size_t count = 0;
+    double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+// Настройки справедливости планирования Game_host
+struct host_fairness
+{
+    int max_level = 12;        // Потолок уровня бота для любой партии
+    size_t max_in_flight = 0;  // Сколько поисков одновременно в пуле (0 - по числу потоков)
+};
+
+// Хост для множества независимых партий в одном процессе.
+// У каждой партии своя позиция, история, настройки и свой Logic. Поиски ботов выполняются
+// задачами в общем пуле потоков с перехватом задач, при желании с общей таблицей транспозиций.
+// Справедливость: партии, ждущие хода бота, обслуживаются строго по очереди поступления,
+// в пул одновременно отдаётся не больше max_in_flight поисков, а уровень бота ограничен max_level.
+class Game_host
+{
+  public:
+    // Снимок состояния партии
+    struct Session_state
+    {
+        board_mtx mtx;
+        bool color;       // Чей ход: 0 - белые, 1 - чёрные
+        int turn_num;     // Количество сделанных ходов
+        int result;       // -1 - идёт, 0 - ничья, 1 - победа белых, 2 - победа чёрных
+        bool searching;   // Бот сейчас думает над ходом
+    };
+
+    Game_host(const size_t threads, const size_t shared_tt_mb = 0, const host_fairness fairness = host_fairness())
+        : fairness(fairness), pool(threads)
+    {
+        if (this->fairness.max_in_flight == 0)
+            this->fairness.max_in_flight = pool.size();
+        if (shared_tt_mb)
+            tt.reset(new Transposition_table(shared_tt_mb));
+    }
+
+    // Отменяет идущие поиски, снимает ждущие партии с очереди и ждёт, пока задачи пула закончатся,
+    // чтобы они не обращались к удалённым партиям. Партии ботов друг против друга не доигрываются
+    ~Game_host()
+    {
+        unique_lock<mutex> lock(host_mtx);
+        stopping = true;  // stop_flag всех партий
+        ready.clear();
+        host_cv.wait(lock, [this] { return in_flight == 0; });
+    }
+
+    // Создаёт партию из начальной позиции, возвращает её номер
+    int create_session(const Settings &settings)
+    {
+        auto s = make_unique<Session>(settings);
+        s->logic.tt = tt.get();
+        s->logic.stop_flag = &stopping;
+        Session *session = s.get();
+        int id;
+        {
+            lock_guard<mutex> lock(host_mtx);
+            id = int(sessions.size());
+            sessions.push_back(move(s));
+            ++active;
+        }
+        lock_guard<mutex> lock(session->state_mtx);
+        advance(*session);
+        return id;
+    }
+
+    // Ход человека: цепочка ходов одной фигуры (для серии взятий - все удары подряд).
+    // Возвращает false, если сейчас ход бота или цепочка не соответствует правилам
+    bool make_move(const int id, const vector<move_pos> &chain)
+    {
+        Session &s = session(id);
+        lock_guard<mutex> lock(s.state_mtx);
+        const bool color = s.turn_num % 2;
+        if (s.result != -1 || s.searching || s.settings.is_bot[color] || chain.empty())
+            return false;
+
+        board_mtx pos = s.mtx;
+        s.logic.find_turns(color, pos);
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            // Ищем ход среди разрешённых, чтобы взять из него координаты побитой фигуры
+            const move_pos *turn = nullptr;
+            for (const auto &t : s.logic.turns)
+                if (t == chain[i])
+                    turn = &t;
+            if (!turn || (i > 0 && !s.logic.have_beats))
+                return false;
+            const bool is_beat = (turn->xb != -1);
+            pos = Logic::make_turn(pos, *turn);
+            if (!is_beat)
+            {
+                if (i + 1 != chain.size())
+                    return false;
+                break;
+            }
+            s.logic.find_turns(chain[i].x2, chain[i].y2, pos);
+            if (s.logic.have_beats && i + 1 == chain.size())
+                return false;  // Серия взятий не доведена до конца
+        }
+        apply(s, pos);
+        return true;
+    }
+
+    Session_state state(const int id)
+    {
+        Session &s = session(id);
+        lock_guard<mutex> lock(s.state_mtx);
+        return {s.mtx, bool(s.turn_num % 2), s.turn_num, s.result, s.searching};
+    }
+
+    // История позиций партии, начиная с начальной
+    vector<board_mtx> history(const int id)
+    {
+        Session &s = session(id);
+        lock_guard<mutex> lock(s.state_mtx);
+        return s.history;
+    }
+
+    // Задержки ответа бота в одной партии
+    latency_stats stats(const int id)
+    {
+        Session &s = session(id);
+        lock_guard<mutex> lock(s.state_mtx);
+        return summarize(s.latencies);
+    }
+
+    // Задержки ответа бота по всем партиям
+    latency_stats stats_all()
+    {
+        vector<double> all;
+        for (int id = 0; id < sessions_count(); ++id)
+        {
+            Session &s = session(id);
+            lock_guard<mutex> lock(s.state_mtx);
+            all.insert(all.end(), s.latencies.begin(), s.latencies.end());
+        }
+        return summarize(move(all));
+    }
+
+    int sessions_count()
+    {
+        lock_guard<mutex> lock(host_mtx);
+        return int(sessions.size());
+    }
+
+    // Ждёт, пока все партии закончатся (имеет смысл, когда за обе стороны играют боты)
+    void wait_all()
+    {
+        unique_lock<mutex> lock(host_mtx);
+        host_cv.wait(lock, [this] { return active == 0; });
+    }
+
+  private:
+    struct Session
+    {
+        explicit Session(const Settings &settings)
+            : settings(settings),
+              logic(settings.scoring, settings.optimization, settings.no_random ? 0 : random_device()())
+        {
+            logic.solver_mb = settings.solver_mb;
+            mtx = Logic::start_mtx();
+            history.push_back(mtx);
+        }
+
+        mutex state_mtx;  // Защищает все поля ниже, кроме logic во время поиска
+        Settings settings;
+        Logic logic;
+        board_mtx mtx{};
+        vector<board_mtx> history;
+        int turn_num = 0;
+        int result = -1;
+        bool searching = false;
+        chrono::steady_clock::time_point requested;  // Когда бот получил право хода
+        vector<double> latencies;
+    };
+
+    Session &session(const int id)
+    {
+        lock_guard<mutex> lock(host_mtx);
+        return *sessions.at(id);
+    }
+
+    // Применяет сделанный ход и передаёт право хода дальше (вызывается под блокировкой партии)
+    void apply(Session &s, const board_mtx &pos)
+    {
+        s.mtx = pos;
+        s.history.push_back(pos);
+        ++s.turn_num;
+        advance(s);
+    }
+
+    // Проверяет конец партии и, если ходит бот, ставит партию в очередь на поиск
+    void advance(Session &s)
+    {
+        const bool color = s.turn_num % 2;
+        s.logic.find_turns(color, s.mtx);
+        if (s.turn_num >= s.settings.max_turns || s.logic.turns.empty())
+        {
+            s.result = (s.turn_num >= s.settings.max_turns ? 0 : (color ? 1 : 2));
+            lock_guard<mutex> lock(host_mtx);
+            --active;
+            host_cv.notify_all();
+            return;
+        }
+        if (!s.settings.is_bot[color])
+            return;
+        s.searching = true;
+        s.requested = chrono::steady_clock::now();
+        lock_guard<mutex> lock(host_mtx);
+        ready.push_back(&s);
+        dispatch();
+    }
+
+    // Отдаёт в пул партии из очереди, пока не достигнут предел одновременных поисков
+    // (вызывается под host_mtx)
+    void dispatch()
+    {
+        while (!stopping && in_flight < fairness.max_in_flight && !ready.empty())
+        {
+            Session *s = ready.front();
+            ready.pop_front();
+            ++in_flight;
+            pool.submit([this, s] { search(*s); });
+        }
+    }
+
+    // Задача пула: поиск хода бота и его применение
+    void search(Session &s)
+    {
+        board_mtx pos;
+        bool color;
+        {
+            lock_guard<mutex> lock(s.state_mtx);
+            pos = s.mtx;
+            color = s.turn_num % 2;
+            s.logic.Max_depth = min(s.settings.bot_level[color], fairness.max_level);
+        }
+        // Партия помечена searching, поэтому её Logic сейчас используется только здесь
+        const auto turns = s.logic.find_best_turns(pos, color);
+        for (const auto &turn : turns)
+            pos = Logic::make_turn(pos, turn);
+
+        // Хост удаляется: результат прерванного поиска отбрасывается
+        if (s.logic.stopped())
+        {
+            lock_guard<mutex> lock(host_mtx);
+            --in_flight;
+            host_cv.notify_all();
+            return;
+        }
+        {
+            lock_guard<mutex> lock(s.state_mtx);
+            s.latencies.push_back(
+                chrono::duration<double, milli>(chrono::steady_clock::now() - s.requested).count());
+            s.searching = false;
+            apply(s, pos);
+        }
+        lock_guard<mutex> lock(host_mtx);
+        --in_flight;
+        dispatch();
+        host_cv.notify_all();
+    }
+
+    static latency_stats summarize(vector<double> samples)
+    {
+        latency_stats res;
+        res.count = samples.size();
+        if (samples.empty())
+            return res;
+        sort(samples.begin(), samples.end());
+        auto percentile = [&samples](const double p) { return samples[size_t(p * (samples.size() - 1))]; };
+        for (double v : samples)
+            res.mean += v;
+        res.mean /= samples.size();
+        res.p50 = percentile(0.50);
+        res.p95 = percentile(0.95);
+        res.p99 = percentile(0.99);
+        res.max = samples.back();
+        return res;
+    }
+
+  private:
+    host_fairness fairness;
+    unique_ptr<Transposition_table> tt;  // Общая таблица транспозиций (может отсутствовать)
+
+    mutex host_mtx;  // Защищает sessions, ready, in_flight и active
+    condition_variable host_cv;
+    vector<unique_ptr<Session>> sessions;
+    deque<Session *> ready;  // Партии, ждущие поиска, в порядке запроса
+    size_t in_flight = 0;    // Поисков сейчас в пуле
+    size_t active = 0;       // Незавершённых партий
+    atomic<bool> stopping{false};  // Хост удаляется, общий stop_flag поисков всех партий
+
+    Thread_pool pool;  // Объявлен последним, чтобы потоки останавливались первыми
+};
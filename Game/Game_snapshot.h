@@ -0,0 +1,235 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <filesystem>
+    #include <fstream>
+    #include <iterator>
+#endif
+
+#include "../Models/Move.h"
+#include "../Models/Settings.h"
+
+using namespace std;
+
+// Состояние партии для возобновления после выхода или падения
+struct saved_game
+{
+    int turn_num = 0;     // Номер хода, сторона хода - turn_num % 2
+    int max_turns = 0;    // Game.MaxNumTurns партии
+    bool is_bot[2] = {false, false};
+    int bot_level[2] = {0, 0};
+    Bot_engine engine[2] = {Bot_engine::AlphaBeta, Bot_engine::AlphaBeta};
+    Scoring scoring = Scoring::NumberAndPotential;
+    Optimization optimization = Optimization::O1;
+    string random_state;                   // Состояние генератора случайных чисел бота (Logic)
+    vector<vector<vector<POS_T>>> history;  // Доски после каждого хода, первая - начальная
+    vector<int> beat_series;                // Серия взятий для каждой доски истории
+};
+
+// Двоичный снимок партии в файле.
+// Формат: заголовок (сигнатура, версия, размер, контрольная сумма) и поля saved_game подряд,
+// доска истории - 64 байта клеток и байт серии взятий. Запись атомарна: снимок пишется во временный
+// файл, сбрасывается на диск и переименовывается поверх старого, поэтому при падении в файле остаётся
+// либо прежний, либо новый снимок целиком. При чтении файл отображается в память, снимок с другой
+// версией, обрезанный или с неверной контрольной суммой отбрасывается.
+class Game_snapshot
+{
+  public:
+    // Пишет снимок в path. Возвращает false, если записать не удалось
+    static bool save(const string &path, const saved_game &game)
+    {
+        vector<char> body;
+        put(body, int32_t(game.turn_num));
+        put(body, int32_t(game.max_turns));
+        for (int color = 0; color < 2; ++color)
+        {
+            put(body, uint8_t(game.is_bot[color]));
+            put(body, int32_t(game.bot_level[color]));
+            put(body, uint8_t(game.engine[color]));
+        }
+        put(body, uint8_t(game.scoring));
+        put(body, uint8_t(game.optimization));
+        put(body, uint32_t(game.random_state.size()));
+        body.insert(body.end(), game.random_state.begin(), game.random_state.end());
+        put(body, uint32_t(game.history.size()));
+        for (size_t k = 0; k < game.history.size(); ++k)
+        {
+            for (const auto &row : game.history[k])
+                for (const POS_T cell : row)
+                    put(body, int8_t(cell));
+            put(body, int8_t(game.beat_series[k]));
+        }
+
+        file_header h{{'C', 'H', 'K', 'R', 'S', 'A', 'V', 0}, File_version, uint32_t(body.size()),
+                      checksum(body.data(), body.size())};
+        vector<char> data(sizeof(h));
+        memcpy(data.data(), &h, sizeof(h));
+        data.insert(data.end(), body.begin(), body.end());
+        return write_atomic(path, data);
+    }
+
+    // Читает снимок из path. Возвращает false, если файла нет или он повреждён
+    static bool load(const string &path, saved_game &game)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+            map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            return false;
+        const bool ok = parse(static_cast<const char *>(map), size_t(st.st_size), game);
+        munmap(map, size_t(st.st_size));
+        return ok;
+#else
+        ifstream fin(path, ios::binary);
+        const vector<char> data((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+        return !data.empty() && parse(data.data(), data.size(), game);
+#endif
+    }
+
+    // Удаляет снимок законченной партии
+    static void remove(const string &path)
+    {
+        std::remove(path.c_str());
+    }
+
+  private:
+    static constexpr uint32_t File_version = 1;
+    static constexpr int Board_size = 8;
+
+    struct file_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t size;      // Байт после заголовка
+        uint64_t checksum;  // FNV-1a байтов после заголовка
+    };
+
+    template <class T> static void put(vector<char> &out, const T value)
+    {
+        const char *p = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    // Читает значение из [pos, end), сдвигая pos. Возвращает false, если данных не хватает
+    template <class T> static bool get(const char *&pos, const char *end, T &value)
+    {
+        if (size_t(end - pos) < sizeof(T))
+            return false;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    static uint64_t checksum(const char *data, const size_t size)
+    {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t k = 0; k < size; ++k)
+            h = (h ^ uint8_t(data[k])) * 0x100000001b3ull;
+        return h;
+    }
+
+    static bool parse(const char *data, const size_t size, saved_game &game)
+    {
+        file_header h;
+        if (size < sizeof(h))
+            return false;
+        memcpy(&h, data, sizeof(h));
+        if (memcmp(h.magic, "CHKRSAV", 8) || h.version != File_version || h.size != size - sizeof(h) ||
+            h.checksum != checksum(data + sizeof(h), h.size))
+            return false;
+
+        const char *pos = data + sizeof(h), *end = data + size;
+        saved_game g;
+        int32_t turn_num, max_turns, level;
+        uint8_t flag, scoring, optimization;
+        if (!get(pos, end, turn_num) || !get(pos, end, max_turns))
+            return false;
+        g.turn_num = turn_num;
+        g.max_turns = max_turns;
+        for (int color = 0; color < 2; ++color)
+        {
+            if (!get(pos, end, flag) || !get(pos, end, level))
+                return false;
+            g.is_bot[color] = flag;
+            g.bot_level[color] = level;
+            if (!get(pos, end, flag))
+                return false;
+            g.engine[color] = Bot_engine(flag);
+        }
+        uint32_t len;
+        if (!get(pos, end, scoring) || !get(pos, end, optimization) || !get(pos, end, len) ||
+            size_t(end - pos) < len)
+            return false;
+        g.scoring = Scoring(scoring);
+        g.optimization = Optimization(optimization);
+        g.random_state.assign(pos, len);
+        pos += len;
+
+        uint32_t count;
+        if (!get(pos, end, count) || count == 0 || size_t(end - pos) != size_t(count) * (Board_size * Board_size + 1))
+            return false;
+        g.history.assign(count, vector<vector<POS_T>>(Board_size, vector<POS_T>(Board_size)));
+        g.beat_series.resize(count);
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            for (auto &row : g.history[k])
+                for (auto &cell : row)
+                    cell = POS_T(*pos++);
+            g.beat_series[k] = int8_t(*pos++);
+        }
+        game = move(g);
+        return true;
+    }
+
+    // Пишет data во временный файл, сбрасывает его на диск и переименовывает в path
+    static bool write_atomic(const string &path, const vector<char> &data)
+    {
+        const string tmp = path + ".tmp";
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        size_t done = 0;
+        while (done < data.size())
+        {
+            const ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if (n <= 0)
+                break;
+            done += size_t(n);
+        }
+        const bool ok = (done == data.size() && fsync(fd) == 0);
+        close(fd);
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+#else
+        {
+            ofstream fout(tmp, ios::binary | ios::trunc);
+            fout.write(data.data(), streamsize(data.size()));
+            if (!fout.flush())
+                return false;
+        }
+        error_code ec;
+        filesystem::rename(tmp, path, ec);
+        return !ec;
+#endif
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "../Models/Move.h"
+
+// Координаты клетки на доске
+struct cell_pos
+{
+    POS_T x, y;
+};
+
+// Таблицы геометрии доски N x N, вычисляемые на этапе компиляции.
+// Все N * N / 2 игровые (тёмные) клетки пронумерованы построчно: индекс = x * (N / 2) + y / 2.
+// Направления диагоналей перечислены в том же порядке, в котором их обходил Logic:
+// 0 - (-1, -1), 1 - (-1, +1), 2 - (+1, -1), 3 - (+1, +1).
+template <int N> struct Basic_geometry
+{
+    static constexpr int Size = N;             // Размер стороны доски
+    static constexpr int Cells = N * N / 2;    // Количество игровых клеток
+    static constexpr int Dirs = 4;             // Количество диагональных направлений
+
+    cell_pos cell[Cells];      // Координаты клетки по её индексу
+    int8_t index[Size][Size];  // Индекс клетки по координатам (-1 для светлых клеток)
+
+    // Лучи по диагоналям от каждой клетки до края доски
+    cell_pos ray[Cells][Dirs][Size - 1];
+    POS_T ray_len[Cells][Dirs];
+
+    // Соседние клетки для тихих ходов простых фигур: [цвет][клетка], 0 - белые (вверх), 1 - чёрные (вниз)
+    cell_pos step[2][Cells][2];
+    POS_T step_cnt[2][Cells];
+
+    // Прыжки простых фигур: клетка, через которую бьём, и клетка, куда встаём
+    cell_pos jump_over[Cells][Dirs];
+    cell_pos jump_to[Cells][Dirs];
+    POS_T jump_cnt[Cells];
+
+    // Маски клеток (бит - индекс клетки), где должна стоять фигура соперника, чтобы фигура с клетки
+    // могла её побить: для простой - клетки jump_over, для дамки - лучи без последней клетки.
+    // Если под маской нет фигур соперника, взятий у фигуры нет и генерировать их не нужно
+    uint64_t man_capture_mask[Cells];
+    uint64_t king_capture_mask[Cells];
+};
+static_assert(Basic_geometry<10>::Cells <= 64, "capture masks need a bit per cell");
+
+// Построение таблиц геометрии
+template <int N> constexpr Basic_geometry<N> make_geometry()
+{
+    using G = Basic_geometry<N>;
+    constexpr POS_T dx[G::Dirs] = {-1, -1, 1, 1};
+    constexpr POS_T dy[G::Dirs] = {-1, 1, -1, 1};
+
+    G g{};
+    for (POS_T i = 0; i < G::Size; ++i)
+    {
+        for (POS_T j = 0; j < G::Size; ++j)
+        {
+            g.index[i][j] = -1;
+            if ((i + j) % 2 == 0)
+                continue;
+            const int idx = i * (G::Size / 2) + j / 2;
+            g.index[i][j] = idx;
+            g.cell[idx] = {i, j};
+        }
+    }
+
+    for (int idx = 0; idx < G::Cells; ++idx)
+    {
+        const POS_T x = g.cell[idx].x, y = g.cell[idx].y;
+        for (int d = 0; d < G::Dirs; ++d)
+        {
+            POS_T len = 0;
+            for (int i2 = x + dx[d], j2 = y + dy[d]; i2 >= 0 && i2 < G::Size && j2 >= 0 && j2 < G::Size;
+                 i2 += dx[d], j2 += dy[d])
+            {
+                g.ray[idx][d][len++] = {POS_T(i2), POS_T(j2)};
+            }
+            g.ray_len[idx][d] = len;
+
+            for (POS_T k = 0; k + 1 < len; ++k)
+                g.king_capture_mask[idx] |= uint64_t(1) << g.index[g.ray[idx][d][k].x][g.ray[idx][d][k].y];
+            if (len >= 2)
+            {
+                g.man_capture_mask[idx] |= uint64_t(1) << g.index[g.ray[idx][d][0].x][g.ray[idx][d][0].y];
+                g.jump_over[idx][g.jump_cnt[idx]] = g.ray[idx][d][0];
+                g.jump_to[idx][g.jump_cnt[idx]] = g.ray[idx][d][1];
+                ++g.jump_cnt[idx];
+            }
+            // Белые ходят вверх (направления 0 и 1), чёрные - вниз (направления 2 и 3)
+            const int color = d / 2;
+            if (len >= 1)
+                g.step[color][idx][g.step_cnt[color][idx]++] = g.ray[idx][d][0];
+        }
+    }
+    return g;
+}
+
+template <int N> inline constexpr Basic_geometry<N> basic_geometry = make_geometry<N>();
+
+// Матрица доски фиксированного размера, копирование которой не требует памяти в куче
+template <int N> using basic_board_mtx = std::array<std::array<POS_T, N>, N>;
+
+// Геометрия доски 8x8, на которой играют окно игры, бенчмарк и консольный движок
+using Geometry = Basic_geometry<8>;
+inline constexpr const Geometry &geometry = basic_geometry<8>;
+typedef basic_board_mtx<8> board_mtx;
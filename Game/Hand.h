@@ -1,5 +1,7 @@
 #pragma once
+#include <deque>
 #include <tuple>
+#include <utility>
 
 #include "../Models/Move.h"
 #include "../Models/Response.h"
@@ -16,8 +18,16 @@ class Hand
 
     // Метод для получения координат клетки, по которой кликнул игрок
     // Возвращает кортеж: тип ответа, координаты x и y выбранной клетки
-    tuple<Response, POS_T, POS_T> get_cell() const
+    // Сначала отдаются клики по клеткам, сделанные, пока думал бот (см. poll)
+    tuple<Response, POS_T, POS_T> get_cell()
     {
+        TRACE_SCOPE("Hand::get_cell");
+        if (!queued_cells.empty())
+        {
+            const auto cell = queued_cells.front();
+            queued_cells.pop_front();
+            return {Response::CELL, cell.first, cell.second};
+        }
         SDL_Event windowEvent;  // События SDL
         Response resp = Response::OK;  // Изначально предполагаем, что все действия корректны
         int x = -1, y = -1;  // Координаты курсора
@@ -25,7 +35,7 @@ class Hand
 
         while (true)
         {
-            if (SDL_PollEvent(&windowEvent))  // Проверяем все события SDL
+            if (board->wait_event(windowEvent))  // Ждём следующее событие окна
             {
                 switch (windowEvent.type)
                 {
@@ -72,6 +82,50 @@ class Hand
         return {resp, xc, yc};  // Возвращаем результат: тип ответа и координаты клетки
     }
 
+    // Разбирает накопившиеся события, не дожидаясь новых (пока думает бот, окно остаётся отзывчивым)
+    // Клики по клеткам запоминаются (не больше Max_queued_cells последних) и достаются следующим get_cell,
+    // а после BACK, REPLAY и QUIT забываются. Возвращает QUIT, BACK, REPLAY или OK, если ничего не нажато
+    Response poll()
+    {
+        SDL_Event windowEvent;  // События SDL
+        while (board->poll_event(windowEvent))
+        {
+            switch (windowEvent.type)
+            {
+            case SDL_QUIT:  // Если игрок закрыл окно
+                queued_cells.clear();
+                return Response::QUIT;
+            case SDL_MOUSEBUTTONDOWN:  // Если произошёл клик мыши
+            {
+                int xc = int(windowEvent.motion.y / (board->H / 10) - 1);  // Переводим координаты клика в индексы клетки
+                int yc = int(windowEvent.motion.x / (board->W / 10) - 1);
+                if (xc == -1 && yc == -1 && board->history_mtx.size() > 1)  // Кнопка отката хода
+                {
+                    queued_cells.clear();
+                    return Response::BACK;
+                }
+                if (xc == -1 && yc == 8)  // Кнопка перезапуска
+                {
+                    queued_cells.clear();
+                    return Response::REPLAY;
+                }
+                if (xc >= 0 && xc < 8 && yc >= 0 && yc < 8)  // Клик по клетке доски
+                {
+                    if (queued_cells.size() == Max_queued_cells)
+                        queued_cells.pop_front();
+                    queued_cells.emplace_back(POS_T(xc), POS_T(yc));
+                }
+                break;
+            }
+            case SDL_WINDOWEVENT:
+                if (windowEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)  // Если изменён размер окна
+                    board->reset_window_size();  // Перерисовываем доску
+                break;
+            }
+        }
+        return Response::OK;
+    }
+
     // Метод, который ожидает действий игрока (например, клик по кнопке)
     // Возвращает тип ответа (QUIT, REPLAY, и т.д.)
     Response wait() const
@@ -81,7 +135,7 @@ class Hand
 
         while (true)
         {
-            if (SDL_PollEvent(&windowEvent))  // Проверяем все события SDL
+            if (board->wait_event(windowEvent))  // Ждём следующее событие окна
             {
                 switch (windowEvent.type)
                 {
@@ -108,5 +162,8 @@ class Hand
     }
 
   private:
+    static constexpr size_t Max_queued_cells = 4;
+
     Board *board;  // Указатель на объект доски
+    deque<pair<POS_T, POS_T>> queued_cells;  // Клики по клеткам, сделанные во время хода бота
 };
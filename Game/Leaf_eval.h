@@ -0,0 +1,249 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#include "../Models/Move.h"
+#include "../Models/Settings.h"
+#include "Geometry.h"
+
+// Веса продвижения клеток матрицы N x N: для белых - рядов до нижнего края, для чёрных - до верхнего
+template <int N> struct leaf_advance_weights
+{
+    uint8_t white[N * N];
+    uint8_t black[N * N];
+};
+
+template <int N> constexpr leaf_advance_weights<N> make_leaf_weights()
+{
+    leaf_advance_weights<N> w{};
+    for (int k = 0; k < N * N; ++k)
+    {
+        w.white[k] = uint8_t(N - 1 - k / N);
+        w.black[k] = uint8_t(k / N);
+    }
+    return w;
+}
+
+template <int N> inline constexpr leaf_advance_weights<N> leaf_weights = make_leaf_weights<N>();
+
+// Оценка листьев поиска, в том числе пачкой соседних позиций.
+// Оценка сводится к целым счётчикам: числу простых фигур и дамок каждого цвета и сумме продвижения
+// простых фигур (на сколько рядов фигура ушла от своего края). Позиция упаковывается в эти счётчики
+// векторным сравнением всех клеток сразу (AVX2 - по 32 клетки, SSE2 - по 16), а отношения сил для
+// пачки позиций считаются векторным делением (4 или 2 за раз). Векторный вариант выбирается флагами
+// компиляции (-mavx2 или SSE2, который есть на любом x86-64), на других процессорах работает
+// скалярный вариант. Все варианты дают одну и ту же оценку до бита.
+template <int N> class Leaf_eval
+{
+  public:
+    using board_mtx = basic_board_mtx<N>;
+
+    // Оценка проигранной позиции, совпадает с INF из Logic.h
+    static constexpr double Lost = 1e9;
+
+    // Набор векторных команд, с которым собрана оценка
+#if defined(__AVX2__)
+    static constexpr const char *Simd = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    static constexpr const char *Simd = "SSE2";
+#else
+    static constexpr const char *Simd = "none";
+#endif
+
+    // Упакованная позиция: счётчики фигур, индекс 0 - белые, 1 - чёрные
+    struct packed
+    {
+        int men[2];
+        int kings[2];
+        int advance[2];  // Сумма продвижения простых фигур в рядах
+    };
+
+    // Оценка одной позиции, как в Logic::calc_score
+    static double score(const board_mtx &mtx, const Scoring scoring, const bool first_bot_color)
+    {
+        return ratio(pack(mtx), scoring, first_bot_color);
+    }
+
+    // Оценки count позиций boards[0..count) в out[0..count)
+    static void score_batch(const board_mtx *boards, const size_t count, const Scoring scoring,
+                            const bool first_bot_color, double *out)
+    {
+        double num[Max_batch], den[Max_batch];
+        for (size_t done = 0; done < count; done += Max_batch)
+        {
+            const size_t n = (count - done < Max_batch ? count - done : Max_batch);
+            for (size_t k = 0; k < n; ++k)
+                fractions(pack(boards[done + k]), scoring, first_bot_color, num[k], den[k]);
+            divide(num, den, n, out + done);
+        }
+    }
+
+    // Скалярная оценка по клеткам, без упаковки и векторных команд (для сравнения в бенчмарке)
+    static double score_scalar(const board_mtx &mtx, const Scoring scoring, const bool first_bot_color)
+    {
+        packed p{};
+        for (int i = 0; i < N; ++i)
+        {
+            for (int j = 0; j < N; ++j)
+            {
+                const POS_T v = mtx[i][j];
+                p.men[0] += (v == 1);
+                p.men[1] += (v == 2);
+                p.kings[0] += (v == 3);
+                p.kings[1] += (v == 4);
+                p.advance[0] += (v == 1) * (N - 1 - i);
+                p.advance[1] += (v == 2) * i;
+            }
+        }
+        return ratio(p, scoring, first_bot_color);
+    }
+
+    // Упаковка позиции в счётчики
+    static packed pack(const board_mtx &mtx)
+    {
+        const auto *cells = reinterpret_cast<const int8_t *>(mtx.data());
+        packed p{};
+        int k = 0;
+#if defined(__AVX2__)
+        // Маски клеток каждого типа фигур, под масками - единицы (для числа фигур) или веса продвижения;
+        // байты суммируются через sad в 64-битные части аккумуляторов
+        const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi8(1);
+        __m256i acc[6] = {zero, zero, zero, zero, zero, zero};
+        for (; k + 32 <= Cells; k += 32)
+        {
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells + k));
+            const __m256i wm = _mm256_cmpeq_epi8(c, one);
+            const __m256i bm = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(2));
+            const __m256i wk = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(3));
+            const __m256i bk = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(4));
+            const __m256i ww = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(leaf_weights<N>.white + k));
+            const __m256i bw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(leaf_weights<N>.black + k));
+            acc[0] = _mm256_add_epi64(acc[0], _mm256_sad_epu8(_mm256_and_si256(wm, one), zero));
+            acc[1] = _mm256_add_epi64(acc[1], _mm256_sad_epu8(_mm256_and_si256(bm, one), zero));
+            acc[2] = _mm256_add_epi64(acc[2], _mm256_sad_epu8(_mm256_and_si256(wk, one), zero));
+            acc[3] = _mm256_add_epi64(acc[3], _mm256_sad_epu8(_mm256_and_si256(bk, one), zero));
+            acc[4] = _mm256_add_epi64(acc[4], _mm256_sad_epu8(_mm256_and_si256(wm, ww), zero));
+            acc[5] = _mm256_add_epi64(acc[5], _mm256_sad_epu8(_mm256_and_si256(bm, bw), zero));
+        }
+        p.men[0] = hsum(acc[0]);
+        p.men[1] = hsum(acc[1]);
+        p.kings[0] = hsum(acc[2]);
+        p.kings[1] = hsum(acc[3]);
+        p.advance[0] = hsum(acc[4]);
+        p.advance[1] = hsum(acc[5]);
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1);
+        __m128i acc[6] = {zero, zero, zero, zero, zero, zero};
+        for (; k + 16 <= Cells; k += 16)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells + k));
+            const __m128i wm = _mm_cmpeq_epi8(c, one);
+            const __m128i bm = _mm_cmpeq_epi8(c, _mm_set1_epi8(2));
+            const __m128i wk = _mm_cmpeq_epi8(c, _mm_set1_epi8(3));
+            const __m128i bk = _mm_cmpeq_epi8(c, _mm_set1_epi8(4));
+            const __m128i ww = _mm_loadu_si128(reinterpret_cast<const __m128i *>(leaf_weights<N>.white + k));
+            const __m128i bw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(leaf_weights<N>.black + k));
+            acc[0] = _mm_add_epi64(acc[0], _mm_sad_epu8(_mm_and_si128(wm, one), zero));
+            acc[1] = _mm_add_epi64(acc[1], _mm_sad_epu8(_mm_and_si128(bm, one), zero));
+            acc[2] = _mm_add_epi64(acc[2], _mm_sad_epu8(_mm_and_si128(wk, one), zero));
+            acc[3] = _mm_add_epi64(acc[3], _mm_sad_epu8(_mm_and_si128(bk, one), zero));
+            acc[4] = _mm_add_epi64(acc[4], _mm_sad_epu8(_mm_and_si128(wm, ww), zero));
+            acc[5] = _mm_add_epi64(acc[5], _mm_sad_epu8(_mm_and_si128(bm, bw), zero));
+        }
+        p.men[0] = hsum(acc[0]);
+        p.men[1] = hsum(acc[1]);
+        p.kings[0] = hsum(acc[2]);
+        p.kings[1] = hsum(acc[3]);
+        p.advance[0] = hsum(acc[4]);
+        p.advance[1] = hsum(acc[5]);
+#endif
+        // Клетки, не вошедшие в целые векторы (и вся доска без SSE2)
+        for (; k < Cells; ++k)
+        {
+            const int8_t v = cells[k];
+            p.men[0] += (v == 1);
+            p.men[1] += (v == 2);
+            p.kings[0] += (v == 3);
+            p.kings[1] += (v == 4);
+            p.advance[0] += (v == 1) * leaf_weights<N>.white[k];
+            p.advance[1] += (v == 2) * leaf_weights<N>.black[k];
+        }
+        return p;
+    }
+
+  private:
+    static constexpr int Cells = N * N;         // Клеток в матрице доски (вместе со светлыми)
+    static constexpr size_t Max_batch = 64;     // Позиций в одном проходе score_batch
+
+    // Числитель и знаменатель отношения сил. Продвижение весит 0.05 фигуры, поэтому для потенциала
+    // всё умножено на 20 и считается в целых, а деление одно - так оценка не зависит от порядка сложения
+    static void fractions(const packed &p, const Scoring scoring, const bool first_bot_color, double &num, double &den)
+    {
+        const int own = (first_bot_color ? 0 : 1);  // Чьи фигуры в знаменателе
+        if (scoring == Scoring::NumberAndPotential)
+        {
+            num = 20 * p.men[1 - own] + p.advance[1 - own] + 100 * p.kings[1 - own];
+            den = 20 * p.men[own] + p.advance[own] + 100 * p.kings[own];
+        }
+        else
+        {
+            num = p.men[1 - own] + 4 * p.kings[1 - own];
+            den = p.men[own] + 4 * p.kings[own];
+        }
+    }
+
+    static double ratio(const packed &p, const Scoring scoring, const bool first_bot_color)
+    {
+        double num, den;
+        fractions(p, scoring, first_bot_color, num, den);
+        // Если у стороны в знаменателе не осталось фигур - максимально плохая оценка,
+        // если у другой стороны - нулевая
+        return (den == 0 ? Lost : num / den);
+    }
+
+    // out[k] = num[k] / den[k], при den[k] == 0 - Lost
+    static void divide(const double *num, const double *den, const size_t n, double *out)
+    {
+        size_t k = 0;
+#if defined(__AVX2__)
+        for (; k + 4 <= n; k += 4)
+        {
+            const __m256d d = _mm256_loadu_pd(den + k);
+            const __m256d q = _mm256_div_pd(_mm256_loadu_pd(num + k), d);
+            const __m256d lost = _mm256_cmp_pd(d, _mm256_setzero_pd(), _CMP_EQ_OQ);
+            _mm256_storeu_pd(out + k, _mm256_blendv_pd(q, _mm256_set1_pd(Lost), lost));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; k + 2 <= n; k += 2)
+        {
+            const __m128d d = _mm_loadu_pd(den + k);
+            const __m128d q = _mm_div_pd(_mm_loadu_pd(num + k), d);
+            const __m128d lost = _mm_cmpeq_pd(d, _mm_setzero_pd());
+            _mm_storeu_pd(out + k, _mm_or_pd(_mm_andnot_pd(lost, q), _mm_and_pd(lost, _mm_set1_pd(Lost))));
+        }
+#endif
+        for (; k < n; ++k)
+            out[k] = (den[k] == 0 ? Lost : num[k] / den[k]);
+    }
+
+    // Сумма 64-битных частей аккумулятора. Суммы sad меньше 2^16, поэтому хватает младших 32 бит:
+    // _mm_cvtsi128_si32 есть и в 32-битных сборках, в отличие от _mm_cvtsi128_si64
+#if defined(__AVX2__)
+    static int hsum(const __m256i v)
+    {
+        const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        return _mm_cvtsi128_si32(_mm_add_epi64(s, _mm_unpackhi_epi64(s, s)));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static int hsum(const __m128i v)
+    {
+        return _mm_cvtsi128_si32(_mm_add_epi64(v, _mm_unpackhi_epi64(v, v)));
+    }
+#endif
+};
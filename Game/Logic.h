@@ -1,38 +1,296 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <ctime>
+#include <memory>
 #include <random>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "../Models/Move.h"
-#include "Board.h"
+#include "../Models/Move_list.h"
+#include "Alloc_counter.h"
 #include "Config.h"
+#include "Geometry.h"
+#include "Leaf_eval.h"
+#include "Proof_search.h"
+#include "Rules.h"
+#include "Trace.h"
+#include "Transposition_table.h"
+#include "Tree_capture.h"
+// Без SDL (флаг CHECKERS_HEADLESS) Logic работает только с явно переданными позициями
+#ifndef CHECKERS_HEADLESS
+    #include "Board.h"
+#else
+class Board;
+#endif
+
+using namespace std;
 
 // Константа для бесконечно большой оценки
 const int INF = 1e9;
 
-class Logic
+// Вариант анализа MultiPV: оценка хода корня и главная линия из полных ходов
+// (тихий ход или вся серия взятий одной фигуры), pv[0] - сам ход корня
+struct pv_line
+{
+    double score;
+    vector<vector<move_pos>> pv;
+};
+
+// Генерация ходов и поиск для варианта правил Rules (Russian_rules, International_rules).
+// Геометрия доски и правила - параметры шаблона, поэтому каждый вариант компилируется
+// в отдельный код с постоянными границами, а 8x8 не платит за поддержку 10x10.
+template <class Rules> class Draughts_logic
 {
 public:
+    // Геометрия, матрица доски и ключи хеширования для размера доски этого варианта
+    using Geometry = Basic_geometry<Rules::Size>;
+    using board_mtx = basic_board_mtx<Rules::Size>;
+    static constexpr const Geometry &geometry = basic_geometry<Rules::Size>;
+    static constexpr const Basic_zobrist<Geometry::Cells> &zobrist = basic_zobrist<Geometry::Cells>;
+    static_assert(4 * Geometry::Cells <= move_list::Capacity, "move_list::Capacity is too small for this board");
+
     // Конструктор класса Logic, инициализирует объект с доской и конфигурацией игры
     // На основе конфигурации инициализируются параметры для бота
-    Logic(Board *board, Config *config) : board(board), config(config)
+    Draughts_logic(Board *board, Config *config) : board(board), config(config)
     {
+        const auto settings = config->get();
         rand_eng = std::default_random_engine(
-            !((*config)("Bot", "NoRandom")) ? unsigned(time(0)) : 0);  // Инициализация генератора случайных чисел
-        scoring_mode = (*config)("Bot", "BotScoringType");  // Тип оценки бота
-        optimization = (*config)("Bot", "Optimization");  // Уровень оптимизации
+            !settings->no_random ? unsigned(time(0)) : 0);  // Инициализация генератора случайных чисел
+        scoring_mode = settings->scoring;  // Тип оценки бота
+        optimization = settings->optimization;  // Уровень оптимизации
+        solver_mb = settings->solver_mb;  // Память решателя
+        // Резервируем арену поиска один раз, дальше её ёмкость переиспользуется между ходами
+        next_move.reserve(Arena_capacity);
+        next_best_state.reserve(Arena_capacity);
+    }
+
+    // Конструктор для поиска без доски и файла настроек (используется бенчмарком)
+    Draughts_logic(const Scoring scoring_mode, const Optimization optimization, const unsigned seed)
+        : rand_eng(seed), scoring_mode(scoring_mode), optimization(optimization), board(nullptr), config(nullptr)
+    {
+        next_move.reserve(Arena_capacity);
+        next_best_state.reserve(Arena_capacity);
     }
 
+#ifndef CHECKERS_HEADLESS
     // Метод для нахождения лучшего хода для бота
+    // Ходы корня берутся из turns, найденных перед этим через find_turns(color)
     vector<move_pos> find_best_turns(const bool color)
     {
+        // Параметры оценки берутся из свежего снимка настроек, поэтому меняются между ходами
+        const auto settings = config->get();
+        scoring_mode = settings->scoring;
+        optimization = settings->optimization;
+        solver_mb = settings->solver_mb;
+        return search_root(to_mtx(board->get_board()), color);
+    }
+#endif
+
+    // Метод для нахождения лучшего хода в заданной позиции
+    vector<move_pos> find_best_turns(const board_mtx &mtx, const bool color)
+    {
+        find_turns(color, mtx);  // Ищем ходы корня
+        return search_root(mtx, color);
+    }
+
+    // Режим анализа MultiPV: до count лучших ходов корня с оценками и главными линиями, от лучшего к худшему.
+    // Каждый следующий ход корня ищется с окном от оценки худшей из уже найденных count линий, поэтому
+    // заведомо слабые ходы отсекаются быстро, а таблица транспозиций переносит результаты между линиями.
+    // Если своя таблица tt не задана, используется отдельная таблица анализа, живущая между вызовами.
+    vector<pv_line> find_best_lines(const board_mtx &mtx, const bool color, size_t count)
+    {
+        TRACE_SCOPE("Logic::find_best_lines");
+        count = max<size_t>(count, 1);
+        Transposition_table *saved_tt = tt;
+        if (!tt)
+        {
+            if (!analysis_tt)
+                analysis_tt = make_shared<Transposition_table>(Analysis_tt_mb);
+            tt = analysis_tt.get();
+        }
+        nodes = 0;
+
+        vector<vector<move_pos>> chains;
+        collect_chains(mtx, color, chains);
+        vector<pv_line> lines;
+        for (const auto &chain : chains)
+        {
+            // Пока линий меньше count, нужна точная оценка любого хода, дальше - только лучших, чем худшая линия
+            const double alpha = (lines.size() < count ? -1 : lines.back().score);
+            const double line_score = find_best_turns_rec(apply_chain(mtx, chain), 1 - color, 0, alpha);
+            if (stopped())
+                break;
+            if (lines.size() == count && line_score <= alpha)
+                continue;
+            auto pos = upper_bound(lines.begin(), lines.end(), line_score,
+                                   [](const double v, const pv_line &line) { return v > line.score; });
+            lines.insert(pos, pv_line{line_score, {chain}});
+            if (lines.size() > count)
+                lines.pop_back();
+        }
+        for (auto &line : lines)
+            extend_pv(apply_chain(mtx, line.pv[0]), 1 - color, line.pv);
+        if (!lines.empty())
+            score = lines[0].score;
+        tt = saved_tt;
+        return lines;
+    }
+
+    // Взятая фигура, которая по правилам Rules::Captured_stay_until_end стоит на доске до конца серии взятий
+    static constexpr POS_T Taken = 5;
+
+    // Метод для применения хода и получения новой матрицы доски.
+    // Если взятые фигуры снимаются в конце хода, прыжок оставляет побитую фигуру как Taken, а когда фигуре
+    // больше нечего бить, серия заканчивается: все Taken убираются и простая на последней горизонтали
+    // становится дамкой
+    static board_mtx make_turn(board_mtx mtx, const move_pos &turn)
+    {
+        if constexpr (Rules::Captured_stay_until_end)
+        {
+            if (turn.xb != -1)
+            {
+                jump(mtx, turn);
+                move_list captures;
+                add_captures(mtx, turn.x2, turn.y2, captures);
+                if (!captures.empty())
+                    return mtx;  // Серия продолжается
+                for (const cell_pos &c : geometry.cell)
+                    if (mtx[c.x][c.y] == Taken)
+                        mtx[c.x][c.y] = 0;
+                POS_T &piece = mtx[turn.x2][turn.y2];
+                if ((piece == 1 && turn.x2 == 0) || (piece == 2 && turn.x2 == Geometry::Size - 1))
+                    piece += 2;
+                return mtx;
+            }
+        }
+        if (turn.xb != -1)  // Если была побеждена фигура
+            mtx[turn.xb][turn.yb] = 0;  // Убираем её с доски
+        mtx[turn.x2][turn.y2] = mtx[turn.x][turn.y];  // Перемещаем фигуру на новое место
+        mtx[turn.x][turn.y] = 0;  // Освобождаем старую клетку
+        POS_T &piece = mtx[turn.x2][turn.y2];
+        if ((piece == 1 && turn.x2 == 0) || (piece == 2 && turn.x2 == Geometry::Size - 1))
+        {
+            // Если правила запрещают превращение посреди серии, простая, которая может бить дальше, остаётся простой
+            if constexpr (!Rules::Promote_during_capture)
+            {
+                move_list captures;
+                if (turn.xb != -1 && (add_captures(mtx, turn.x2, turn.y2, captures), !captures.empty()))
+                    return mtx;
+            }
+            piece += 2;  // Преобразуем фигуру в дамку
+        }
+        return mtx;
+    }
+
+    // Начальная расстановка: по Rules::Start_rows рядов чёрных сверху и белых снизу
+    static board_mtx start_mtx()
+    {
+        board_mtx mtx{};
+        for (const cell_pos &c : geometry.cell)
+        {
+            if (c.x < Rules::Start_rows)
+                mtx[c.x][c.y] = 2;
+            if (c.x >= Geometry::Size - Rules::Start_rows)
+                mtx[c.x][c.y] = 1;
+        }
+        return mtx;
+    }
+
+    // Был ли последний поиск прерван через stop_flag (его результат тогда неполный)
+    bool stopped() const
+    {
+        return stop_flag && stop_flag->load(memory_order_relaxed);
+    }
+
+    // Состояние генератора случайных чисел, чтобы возобновлённая партия продолжалась теми же ходами бота
+    string random_state() const
+    {
+        ostringstream out;
+        out << rand_eng;
+        return out.str();
+    }
+
+    void set_random_state(const string &state)
+    {
+        istringstream in(state);
+        default_random_engine eng;
+        if (in >> eng)
+            rand_eng = eng;
+    }
+
+    // Применяет к позиции полный ход (серию взятий целиком)
+    static board_mtx apply_chain(board_mtx mtx, const vector<move_pos> &chain)
+    {
+        for (const auto &turn : chain)
+            mtx = make_turn(mtx, turn);
+        return mtx;
+    }
+
+    // Собирает все полные ходы стороны color: тихие ходы и серии взятий, доведённые до конца
+    void collect_chains(const board_mtx &mtx, const bool color, vector<vector<move_pos>> &out)
+    {
+        find_turns(color, mtx);
+        const move_list first = turns;
+        const bool beats = have_beats;
+        for (const auto &turn : first)
+        {
+            vector<move_pos> chain = {turn};
+            if (beats)
+                extend_chain(make_turn(mtx, turn), chain, out);
+            else
+                out.push_back(chain);
+        }
+    }
+
+    // Переводит матрицу доски из Board в массив фиксированного размера для поиска
+    static board_mtx to_mtx(const vector<vector<POS_T>> &src)
+    {
+        board_mtx mtx;
+        for (POS_T i = 0; i < Geometry::Size; ++i)
+            for (POS_T j = 0; j < Geometry::Size; ++j)
+                mtx[i][j] = src[i][j];
+        return mtx;
+    }
+
+private:
+    // Поиск лучшей цепочки ходов от корня, ходы корня должны быть уже в turns
+    vector<move_pos> search_root(const board_mtx &mtx, const bool color)
+    {
+        TRACE_SCOPE("Logic::search");
+        ALLOC_DEPTH_SCOPE(0);  // Корень, решатель и сборка ответа - глубина 0
+        // Сбрасываем арену поиска (память не освобождается)
         next_best_state.clear();
         next_move.clear();
+        nodes = 0;
+
+        // При решающем перевесе сначала пробуем доказать форсированный выигрыш
+        vector<move_pos> res;
+        if (prove_win(mtx, color, res))
+            return res;
 
+#ifdef CHECKERS_ALLOC_CHECK
+        const size_t allocs_before = alloc_thread_count;  // Считаются только выделения потока поиска
+#endif
+#ifdef CHECKERS_TREE_CAPTURE
+        if (tree)
+            tree->begin_search(position_key<Geometry::Size>(mtx) ^ zobrist.side[color], color);
+#endif
         // Находим первый лучший ход
-        find_first_best_turn(board->get_board(), color, -1, -1, 0);
+        score = find_first_best_turn(mtx, color, -1, -1, 0);
+#ifdef CHECKERS_TREE_CAPTURE
+        if (tree)
+            tree->end_search(score);
+#endif
+#ifdef CHECKERS_ALLOC_CHECK
+        last_search_allocs = alloc_thread_count - allocs_before;
+        assert(last_search_allocs == 0 && "bot search must not allocate");
+#endif
 
         int cur_state = 0;
-        vector<move_pos> res;
         // Строим цепочку ходов
         do
         {
@@ -42,69 +300,122 @@ public:
         return res;
     }
 
-private:
-    // Метод для применения хода и получения новой матрицы доски
-    vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, move_pos turn) const
+    // Решатель запускается, когда оценка позиции для ходящей стороны не меньше Solve_threshold.
+    // При доказанном выигрыше в res - первый ход выигрывающей линии, а score = INF.
+    // Ходы корня в turns и генератор случайных чисел сохраняются, чтобы при неудаче обычный поиск
+    // шёл так же, как без решателя. После неудачи решатель ждёт изменения материала на доске
+    bool prove_win(const board_mtx &mtx, const bool color, vector<move_pos> &res)
     {
-        if (turn.xb != -1)  // Если была побеждена фигура
-            mtx[turn.xb][turn.yb] = 0;  // Убираем её с доски
-        if ((mtx[turn.x][turn.y] == 1 && turn.x2 == 0) || (mtx[turn.x][turn.y] == 2 && turn.x2 == 7))
-            mtx[turn.x][turn.y] += 2;  // Преобразуем фигуру в дамку
-        mtx[turn.x2][turn.y2] = mtx[turn.x][turn.y];  // Перемещаем фигуру на новое место
-        mtx[turn.x][turn.y] = 0;  // Освобождаем старую клетку
-        return mtx;
+        if (!solver_mb || calc_score(mtx, color) < Solve_threshold)
+            return false;
+        const auto packed = Leaf_eval<Geometry::Size>::pack(mtx);
+        const uint64_t material = uint64_t(packed.men[0]) | uint64_t(packed.men[1]) << 16 |
+                                  uint64_t(packed.kings[0]) << 32 | uint64_t(packed.kings[1]) << 48;
+        if (material == unsolved_material)
+            return false;
+        TRACE_SCOPE("Logic::prove_win");
+        if (!solver || solver_mb != solver_table_mb)
+        {
+            solver = make_shared<Proof_search<Draughts_logic>>(solver_mb);
+            solver_table_mb = solver_mb;
+        }
+        const move_list root_turns = turns;
+        const bool root_beats = have_beats;
+        const auto saved_rand = rand_eng;
+        // Бюджет узлов - шестнадцатая часть слотов таблицы: доказательство помещается в неё с запасом,
+        // а неудачная попытка стоит не больше нескольких обычных поисков
+        const size_t max_nodes = solver->table_slots() / 16;
+        vector<vector<move_pos>> line;
+        const auto result = solver->solve(*this, mtx, color, max_nodes, line);
+        nodes += solver->nodes;
+        turns = root_turns;
+        have_beats = root_beats;
+        rand_eng = saved_rand;
+        if (result != Proof_search<Draughts_logic>::Result::Win)
+        {
+            unsolved_material = material;
+            return false;
+        }
+        win_line = line;
+        res = line[0];
+        score = INF;
+        return true;
     }
 
-    // Метод для вычисления оценки состояния доски в зависимости от выбранной стратегии бота
-    double calc_score(const vector<vector<POS_T>> &mtx, const bool first_bot_color) const
+    // Продолжает серию взятий chain из позиции mtx всеми способами
+    void extend_chain(const board_mtx &mtx, vector<move_pos> &chain, vector<vector<move_pos>> &out)
     {
-        double w = 0, wq = 0, b = 0, bq = 0;
-        // Проходим по всем клеткам доски и считаем количество фигур каждого типа
-        for (POS_T i = 0; i < 8; ++i)
+        find_captures(chain.back().x2, chain.back().y2, mtx);
+        if (!have_beats)
         {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                w += (mtx[i][j] == 1);  // Белая фигура
-                wq += (mtx[i][j] == 3);  // Белая дамка
-                b += (mtx[i][j] == 2);  // Чёрная фигура
-                bq += (mtx[i][j] == 4);  // Чёрная дамка
-                // Если используется стратегия "NumberAndPotential", добавляем потенциал
-                if (scoring_mode == "NumberAndPotential")
-                {
-                    w += 0.05 * (mtx[i][j] == 1) * (7 - i);  // Белые фигуры получают бонус за расположение на поле
-                    b += 0.05 * (mtx[i][j] == 2) * (i);  // Чёрные фигуры получают бонус за расположение на поле
-                }
-            }
+            out.push_back(chain);
+            return;
         }
-        // Меняем местами белые и чёрные, если бот играет за чёрных
-        if (!first_bot_color)
+        const move_list next = turns;
+        for (const auto &turn : next)
         {
-            swap(b, w);
-            swap(bq, wq);
+            chain.push_back(turn);
+            extend_chain(make_turn(mtx, turn), chain, out);
+            chain.pop_back();
         }
-        // Если все белые или чёрные фигуры уничтожены, возвращаем максимально плохую или хорошую оценку
-        if (w + wq == 0)
-            return INF;
-        if (b + bq == 0)
-            return 0;
-        
-        int q_coef = 4;  // Коэффициент для дамок
-        if (scoring_mode == "NumberAndPotential")
+    }
+
+    // Достраивает главную линию после хода корня: на каждом полуходе берёт ход, лучший для ходящей стороны.
+    // Поиски остатков линии неглубокие и в основном отвечаются из таблицы транспозиций
+    void extend_pv(board_mtx mtx, bool color, vector<vector<move_pos>> &pv)
+    {
+        for (int depth = 0; depth < Max_depth && !stopped(); ++depth)
         {
-            q_coef = 5;  // Для стратегии с потенциалом увеличиваем вес дамок
+            vector<vector<move_pos>> chains;
+            collect_chains(mtx, color, chains);
+            if (chains.empty())
+                break;
+            size_t best = 0;
+            double best_score = 0;
+            for (size_t i = 0; i < chains.size(); ++i)
+            {
+                const double s = find_best_turns_rec(apply_chain(mtx, chains[i]), 1 - color, depth + 1);
+                // На чётной глубине ходит соперник и минимизирует оценку, на нечётной - бот и максимизирует
+                if (i == 0 || (depth % 2 ? s > best_score : s < best_score))
+                {
+                    best = i;
+                    best_score = s;
+                }
+            }
+            pv.push_back(chains[best]);
+            mtx = apply_chain(mtx, chains[best]);
+            color = !color;
         }
-        return (b + bq * q_coef) / (w + wq * q_coef);  // Оценка соотношения сил
+    }
+
+    // Метод для вычисления оценки состояния доски в зависимости от выбранной стратегии бота
+    // Оценка - отношение сил сторон (фигуры, дамки и при "NumberAndPotential" продвижение фигур),
+    // считается через упакованные счётчики Leaf_eval
+    double calc_score(const board_mtx &mtx, const bool first_bot_color) const
+    {
+        return Leaf_eval<Geometry::Size>::score(mtx, scoring_mode, first_bot_color);
+    }
+
+    // Оценивает пачкой до Leaf_batch соседних листьев: позиции после ходов turns[first..] из mtx
+    void eval_leaf_batch(const board_mtx &mtx, const move_list &turns_now, const size_t first,
+                         const bool first_bot_color)
+    {
+        const size_t n = min(Leaf_batch, turns_now.size() - first);
+        for (size_t k = 0; k < n; ++k)
+            leaf_boards[k] = make_turn(mtx, turns_now[first + k]);
+        Leaf_eval<Geometry::Size>::score_batch(leaf_boards, n, scoring_mode, first_bot_color, leaf_scores);
     }
 
     // Метод для нахождения лучшего хода в начале
-    double find_first_best_turn(vector<vector<POS_T>> mtx, const bool color, const POS_T x, const POS_T y, size_t state,
+    double find_first_best_turn(const board_mtx &mtx, const bool color, const POS_T x, const POS_T y, size_t state,
                                 double alpha = -1)
     {
+        ++nodes;
         next_best_state.push_back(-1);
         next_move.emplace_back(-1, -1, -1, -1);
         double best_score = -1;
         if (state != 0)
-            find_turns(x, y, mtx);  // Ищем доступные ходы для фигуры
+            find_captures(x, y, mtx);  // Продолжение серии: нужны только взятия фигуры
         auto turns_now = turns;
         bool have_beats_now = have_beats;
 
@@ -114,14 +425,13 @@ private:
             return find_best_turns_rec(mtx, 1 - color, 0, alpha);
         }
 
-        vector<move_pos> best_moves;
-        vector<int> best_states;
-
         // Для каждого доступного хода находим лучший ход
-        for (auto turn : turns_now)
+        for (const auto &turn : turns_now)
         {
             size_t next_state = next_move.size();
             double score;
+            if (state == 0)
+                TREE_MOVE(turn);  // Узел после хода корня помечается первым ударом серии
             if (have_beats_now)
             {
                 score = find_first_best_turn(make_turn(mtx, turn), color, turn.x2, turn.y2, next_state, best_score);
@@ -136,23 +446,50 @@ private:
                 next_best_state[state] = (have_beats_now ? int(next_state) : -1);
                 next_move[state] = turn;
             }
+            if (state == 0 && root_progress)
+                root_progress->fetch_add(1, memory_order_relaxed);
         }
         return best_score;
     }
 
     // Рекурсивный метод для нахождения лучшего хода с использованием альфа-бета отсечения
-    double find_best_turns_rec(vector<vector<POS_T>> mtx, const bool color, const size_t depth, double alpha = -1,
+    double find_best_turns_rec(const board_mtx &mtx, const bool color, const size_t depth, double alpha = -1,
                                double beta = INF + 1, const POS_T x = -1, const POS_T y = -1)
     {
+        ++nodes;
+        ALLOC_DEPTH_SCOPE(depth + 1);
+        TREE_NODE(mtx, color, depth, alpha, beta, x != -1);
+        // Поиск отменён: результат всё равно будет отброшен
+        if (stop_flag && stop_flag->load(memory_order_relaxed))
+            return TREE_RESULT(0, Tree_reason::Stopped);
         // Если достигли максимальной глубины рекурсии, возвращаем оценку текущего состояния
         if (depth == Max_depth)
         {
-            return calc_score(mtx, (depth % 2 == color));
+            return TREE_RESULT(calc_score(mtx, (depth % 2 == color)), Tree_reason::Horizon);
+        }
+
+        // Проверяем таблицу транспозиций (только для узлов вне серии взятий)
+        const bool use_tt = tt && x == -1 && optimization != Optimization::O0;
+        const int remaining = Max_depth - int(depth);
+        const double alpha_orig = alpha, beta_orig = beta;
+        uint64_t key = 0;
+        if (use_tt)
+        {
+            key = position_key<Geometry::Size>(mtx) ^ zobrist.side[color] ^ zobrist.parity[depth % 2] ^
+                  zobrist.scoring[int(scoring_mode)];
+            Transposition_table::entry e;
+            if (tt->probe(key, remaining, e) &&
+                (e.bound == Transposition_table::Bound::Exact ||
+                 (e.bound == Transposition_table::Bound::Lower && e.value >= beta) ||
+                 (e.bound == Transposition_table::Bound::Upper && e.value <= alpha)))
+            {
+                return TREE_RESULT(e.value, Tree_reason::Tt_hit);
+            }
         }
 
         if (x != -1)
         {
-            find_turns(x, y, mtx);  // Ищем доступные ходы для данной клетки
+            find_captures(x, y, mtx);  // Продолжение серии: нужны только взятия фигуры
         }
         else
             find_turns(color, mtx);  // Ищем доступные ходы для игрока
@@ -163,24 +500,41 @@ private:
         // Если нет доступных ходов или ходов с ударом, возвращаем оценку текущего состояния
         if (!have_beats_now && x != -1)
         {
-            return find_best_turns_rec(mtx, 1 - color, depth + 1, alpha, beta);
+            return TREE_RESULT(find_best_turns_rec(mtx, 1 - color, depth + 1, alpha, beta), Tree_reason::Chain_end);
         }
 
         if (turns.empty())
-            return (depth % 2 ? 0 : INF);
+        {
+            if (use_tt)
+                tt->store(key, (depth % 2 ? 0 : INF), remaining, Transposition_table::Bound::Exact);
+            return TREE_RESULT((depth % 2 ? 0 : INF), Tree_reason::No_moves);
+        }
 
         double min_score = INF + 1;
         double max_score = -1;
+        // Узел перед горизонтом без взятий: все дети - листья, их оценки считаются пачками соседних позиций
+        const bool leaf_children = !have_beats_now && x == -1 && int(depth) + 1 == Max_depth;
         // Перебираем все возможные ходы
-        for (auto turn : turns_now)
+        for (size_t i = 0; i < turns_now.size(); ++i)
         {
+            const auto &turn = turns_now[i];
             double score = 0.0;
-            if (!have_beats_now && x == -1)
+            if (leaf_children)
+            {
+                if (i % Leaf_batch == 0)
+                    eval_leaf_batch(mtx, turns_now, i, (depth + 1) % 2 == !color);
+                ++nodes;  // Лист считается узлом, как при рекурсивном вызове
+                score = leaf_scores[i % Leaf_batch];
+                TREE_LEAF(mtx, turn, color, depth, alpha, beta, score);
+            }
+            else if (!have_beats_now && x == -1)
             {
+                TREE_MOVE(turn);
                 score = find_best_turns_rec(make_turn(mtx, turn), 1 - color, depth + 1, alpha, beta);
             }
             else
             {
+                TREE_MOVE(turn);
                 score = find_best_turns_rec(make_turn(mtx, turn), color, depth, alpha, beta, turn.x2, turn.y2);
             }
             min_score = min(min_score, score);
@@ -190,138 +544,251 @@ private:
                 alpha = max(alpha, max_score);
             else
                 beta = min(beta, min_score);
-            if (optimization != "O0" && alpha >= beta)  // Если оптимизация включена, применяем отсечение
-                return (depth % 2 ? max_score + 1 : min_score - 1);
+            if (optimization != Optimization::O0 && alpha >= beta)  // Если оптимизация включена, применяем отсечение
+            {
+                // Отсечённый узел даёт только границу: не меньше max_score / не больше min_score
+                if (use_tt && !stopped())
+                    tt->store(key, (depth % 2 ? max_score : min_score), remaining,
+                              depth % 2 ? Transposition_table::Bound::Lower : Transposition_table::Bound::Upper);
+                return TREE_RESULT((depth % 2 ? max_score : min_score), Tree_reason::Cutoff, i + 1, turns_now.size());
+            }
+        }
+        const double res = (depth % 2 ? max_score : min_score);
+        if (use_tt && !stopped())
+        {
+            auto bound = Transposition_table::Bound::Exact;
+            if (res <= alpha_orig)
+                bound = Transposition_table::Bound::Upper;
+            else if (res >= beta_orig)
+                bound = Transposition_table::Bound::Lower;
+            tt->store(key, res, remaining, bound);
         }
-        return (depth % 2 ? max_score : min_score);  // Возвращаем оценку лучшего хода
+        // Оценка лучшего хода
+        return TREE_RESULT(res,
+                           res <= alpha_orig  ? Tree_reason::Fail_low
+                           : res >= beta_orig ? Tree_reason::Fail_high
+                                              : Tree_reason::Exact,
+                           turns_now.size(), turns_now.size());
     }
 
 public:
+#ifndef CHECKERS_HEADLESS
     // Метод для нахождения всех доступных ходов для игрока
     void find_turns(const bool color)
     {
-        find_turns(color, board->get_board());  // Используем текущую доску
+        find_turns(color, to_mtx(board->get_board()));  // Используем текущую доску
     }
 
     // Метод для нахождения доступных ходов для конкретной клетки
     void find_turns(const POS_T x, const POS_T y)
     {
-        find_turns(x, y, board->get_board());  // Используем текущую доску
+        find_turns(x, y, to_mtx(board->get_board()));  // Используем текущую доску
     }
+#endif
 
-private:
-    // Метод для нахождения доступных ходов для заданной клетки
-    void find_turns(const bool color, const vector<vector<POS_T>> &mtx)
+    // Метод для нахождения всех доступных ходов игрока в заданной позиции.
+    // Ходы генерируются по стадиям: сначала только взятия всех фигур, тихие ходы - лишь если взятий нет.
+    // Перед генерацией взятий фигуры маска клеток соперника сверяется с маской клеток, которые фигура
+    // могла бы побить (Geometry::*_capture_mask): без пересечения add_captures не вызывается.
+    // Порядок ходов до перемешивания тот же, что при обходе клеток с find_turns(x, y)
+    void find_turns(const bool color, const board_mtx &mtx)
     {
-        vector<move_pos> res_turns;
-        bool have_beats_before = false;
-        for (POS_T i = 0; i < 8; ++i)
+        turns.clear();
+        int best_capture_len = 0;  // Длина самой длинной серии взятий (для правила большинства)
+        move_list piece;           // Взятия одной фигуры (для правила большинства)
+        int own[Geometry::Cells];  // Индексы клеток фигур игрока
+        int own_cnt = 0;
+        uint64_t enemy = 0;        // Маска клеток фигур соперника
+        for (int idx = 0; idx < Geometry::Cells; ++idx)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            const POS_T v = mtx[geometry.cell[idx].x][geometry.cell[idx].y];
+            if (!v)
+                continue;
+            if (v % 2 == color)
+                enemy |= uint64_t(1) << idx;
+            else
+                own[own_cnt++] = idx;
+        }
+        for (int k = 0; k < own_cnt; ++k)
+        {
+            const int idx = own[k];
+            const POS_T i = geometry.cell[idx].x, j = geometry.cell[idx].y;
+            const uint64_t reach = (mtx[i][j] <= 2 ? geometry.man_capture_mask[idx] : geometry.king_capture_mask[idx]);
+            if (!(reach & enemy))
+                continue;
+            if constexpr (Rules::Majority_capture)
             {
-                if (mtx[i][j] && mtx[i][j] % 2 != color)  // Если клетка занята фигурами противника
+                // Оставляем только фигуры, которые берут наибольшее число шашек
+                piece.clear();
+                add_captures(mtx, i, j, piece);
+                if (piece.empty())
+                    continue;
+                const int len = keep_longest_captures(mtx, piece);
+                if (len < best_capture_len)
+                    continue;
+                if (len > best_capture_len)
                 {
-                    find_turns(i, j, mtx);  // Находим доступные ходы для этой клетки
-                    if (have_beats && !have_beats_before)
-                    {
-                        have_beats_before = true;
-                        res_turns.clear();
-                    }
-                    if ((have_beats_before && have_beats) || !have_beats_before)
-                    {
-                        res_turns.insert(res_turns.end(), turns.begin(), turns.end());
-                    }
+                    best_capture_len = len;
+                    turns.clear();
                 }
+                turns.append(piece);
             }
+            else
+                add_captures(mtx, i, j, turns);
+        }
+        have_beats = !turns.empty();
+        if (!have_beats)
+        {
+            for (int k = 0; k < own_cnt; ++k)
+                add_quiet_moves(mtx, geometry.cell[own[k]].x, geometry.cell[own[k]].y, turns);
         }
-        turns = res_turns;
         shuffle(turns.begin(), turns.end(), rand_eng);  // Перемешиваем ходы для случайности
-        have_beats = have_beats_before;
     }
 
     // Метод для нахождения доступных ходов для конкретной клетки
-    void find_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx)
+    // Использует таблицы geometry, поэтому проверки выхода за край доски не нужны
+    void find_turns(const POS_T x, const POS_T y, const board_mtx &mtx)
+    {
+        turns.clear();
+        add_captures(mtx, x, y, turns);
+        have_beats = !turns.empty();
+        if (have_beats)
+        {
+            if constexpr (Rules::Majority_capture)
+                keep_longest_captures(mtx, turns);
+            return;
+        }
+        add_quiet_moves(mtx, x, y, turns);
+    }
+
+    // Продолжение серии взятий фигурой с клетки (x, y) в позиции после make_turn: только взятия,
+    // тихие ходы не нужны. Если make_turn уже закончил серию и снял взятые фигуры, взятий нет
+    void find_captures(const POS_T x, const POS_T y, const board_mtx &mtx)
     {
         turns.clear();
-        have_beats = false;
-        POS_T type = mtx[x][y];  // Тип фигуры на клетке
-        // Проверяем возможные удары (по диагоналям)
+        add_captures(mtx, x, y, turns);
+        have_beats = !turns.empty();
+        if constexpr (Rules::Captured_stay_until_end)
+        {
+            // Серия идёт, только пока на доске есть взятые фигуры
+            if (have_beats && !series_in_progress(mtx))
+            {
+                turns.clear();
+                have_beats = false;
+            }
+        }
+        if constexpr (Rules::Majority_capture)
+            if (have_beats)
+                keep_longest_captures(mtx, turns);
+    }
+
+private:
+    // Прыжок внутри серии взятий: побитая фигура остаётся на доске как Taken
+    static void jump(board_mtx &mtx, const move_pos &turn)
+    {
+        mtx[turn.xb][turn.yb] = Taken;
+        mtx[turn.x2][turn.y2] = mtx[turn.x][turn.y];
+        mtx[turn.x][turn.y] = 0;
+    }
+
+    // Позиция после прыжка с продолжением серии (для подсчёта длины серии по правилу большинства)
+    static board_mtx series_step(board_mtx mtx, const move_pos &turn)
+    {
+        if constexpr (Rules::Captured_stay_until_end)
+        {
+            jump(mtx, turn);
+            return mtx;
+        }
+        else
+            return make_turn(mtx, turn);
+    }
+
+    static bool series_in_progress(const board_mtx &mtx)
+    {
+        for (const cell_pos &c : geometry.cell)
+            if (mtx[c.x][c.y] == Taken)
+                return true;
+        return false;
+    }
+
+    // Добавляет в out тихие ходы фигуры с клетки (x, y)
+    static void add_quiet_moves(const board_mtx &mtx, const POS_T x, const POS_T y, move_list &out)
+    {
+        const int idx = geometry.index[x][y];
+        const POS_T type = mtx[x][y];  // Тип фигуры на клетке
         switch (type)
         {
         case 1:
         case 2:
-            // Проверяем ходы для обычных фигур
-            for (POS_T i = x - 2; i <= x + 2; i += 4)
             {
-                for (POS_T j = y - 2; j <= y + 2; j += 4)
+                const int side = 1 - type % 2;  // 0 - белые ходят вверх, 1 - чёрные вниз
+                for (POS_T k = 0; k < geometry.step_cnt[side][idx]; ++k)
                 {
-                    if (i < 0 || i > 7 || j < 0 || j > 7)
-                        continue;
-                    POS_T xb = (x + i) / 2, yb = (y + j) / 2;
-                    if (mtx[i][j] || !mtx[xb][yb] || mtx[xb][yb] % 2 == type % 2)
+                    const cell_pos to = geometry.step[side][idx][k];
+                    if (mtx[to.x][to.y])
                         continue;
-                    turns.emplace_back(x, y, i, j, xb, yb);  // Добавляем возможные ходы
+                    out.emplace_back(x, y, to.x, to.y);
                 }
+                break;
             }
-            break;
         default:
             // Проверяем ходы для дамок
-            for (POS_T i = -1; i <= 1; i += 2)
+            for (int d = 0; d < Geometry::Dirs; ++d)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
+                const cell_pos *ray = geometry.ray[idx][d];
+                for (POS_T k = 0; k < geometry.ray_len[idx][d]; ++k)
                 {
-                    POS_T xb = -1, yb = -1;
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                        {
-                            if (mtx[i2][j2] % 2 == type % 2 || (mtx[i2][j2] % 2 != type % 2 && xb != -1))
-                            {
-                                break;
-                            }
-                            xb = i2;
-                            yb = j2;
-                        }
-                        if (xb != -1 && xb != i2)
-                        {
-                            turns.emplace_back(x, y, i2, j2, xb, yb);
-                        }
-                    }
+                    if (mtx[ray[k].x][ray[k].y])
+                        break;
+                    out.emplace_back(x, y, ray[k].x, ray[k].y);
                 }
             }
             break;
         }
-        // Проверяем другие ходы для обычных фигур
-        if (!turns.empty())
-        {
-            have_beats = true;
-            return;
-        }
+    }
+
+    // Добавляет в out все взятия фигуры с клетки (x, y)
+    static void add_captures(const board_mtx &mtx, const POS_T x, const POS_T y, move_list &out)
+    {
+        const int idx = geometry.index[x][y];
+        const POS_T type = mtx[x][y];
         switch (type)
         {
         case 1:
         case 2:
+            // Проверяем ходы для обычных фигур
+            for (POS_T k = 0; k < geometry.jump_cnt[idx]; ++k)
             {
-                POS_T i = ((type % 2) ? x - 1 : x + 1);
-                for (POS_T j = y - 1; j <= y + 1; j += 2)
-                {
-                    if (i < 0 || i > 7 || j < 0 || j > 7 || mtx[i][j])
-                        continue;
-                    turns.emplace_back(x, y, i, j);
-                }
-                break;
+                const cell_pos b = geometry.jump_over[idx][k], to = geometry.jump_to[idx][k];
+                if (mtx[to.x][to.y] || !mtx[b.x][b.y] || mtx[b.x][b.y] % 2 == type % 2 ||
+                    (Rules::Captured_stay_until_end && mtx[b.x][b.y] == Taken))
+                    continue;
+                out.emplace_back(x, y, to.x, to.y, b.x, b.y);  // Добавляем возможные ходы
             }
+            break;
         default:
             // Проверяем ходы для дамок
-            for (POS_T i = -1; i <= 1; i += 2)
+            for (int d = 0; d < Geometry::Dirs; ++d)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
+                const cell_pos *ray = geometry.ray[idx][d];
+                POS_T xb = -1, yb = -1;
+                for (POS_T k = 0; k < geometry.ray_len[idx][d]; ++k)
                 {
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
+                    const POS_T i2 = ray[k].x, j2 = ray[k].y;
+                    if (mtx[i2][j2])
                     {
-                        if (mtx[i2][j2])
+                        // Своя фигура, вторая фигура подряд или уже взятая в этой серии закрывают луч
+                        if (mtx[i2][j2] % 2 == type % 2 || xb != -1 ||
+                            (Rules::Captured_stay_until_end && mtx[i2][j2] == Taken))
+                        {
                             break;
-                        turns.emplace_back(x, y, i2, j2);
+                        }
+                        xb = i2;
+                        yb = j2;
+                    }
+                    if (xb != -1 && xb != i2)
+                    {
+                        out.emplace_back(x, y, i2, j2, xb, yb);
                     }
                 }
             }
@@ -329,17 +796,85 @@ private:
         }
     }
 
+    // Наибольшее число взятий, которое фигура может сделать, продолжая серию с клетки (x, y)
+    static int longest_capture(const board_mtx &mtx, const POS_T x, const POS_T y)
+    {
+        move_list captures;
+        add_captures(mtx, x, y, captures);
+        int best = 0;
+        for (const auto &turn : captures)
+            best = max(best, 1 + longest_capture(series_step(mtx, turn), turn.x2, turn.y2));
+        return best;
+    }
+
+    // Правило большинства: оставляет в list только взятия, начинающие самую длинную серию,
+    // и возвращает её длину
+    static int keep_longest_captures(const board_mtx &mtx, move_list &list)
+    {
+        int len[move_list::Capacity];
+        int best = 0;
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            len[i] = 1 + longest_capture(series_step(mtx, list[i]), list[i].x2, list[i].y2);
+            best = max(best, len[i]);
+        }
+        move_list longest;
+        for (size_t i = 0; i < list.size(); ++i)
+            if (len[i] == best)
+                longest.push_back(list[i]);
+        list = longest;
+        return best;
+    }
+
 public:
-    vector<move_pos> turns;  // Список возможных ходов
+    move_list turns;  // Список возможных ходов
     bool have_beats;  // Флаг, есть ли удары
     int Max_depth;  // Максимальная глубина поиска для минимакс-алгоритма
+    size_t nodes = 0;  // Количество узлов, посещённых за последний поиск
+    double score = 0;  // Оценка лучшего хода за последний поиск
+    // Флаг отмены поиска: проверяется в каждом узле, после установки поиск быстро сворачивается
+    const atomic<bool> *stop_flag = nullptr;
+    // Необязательный счётчик просмотренных ходов корня, по нему окно показывает ход поиска
+    atomic<size_t> *root_progress = nullptr;
+    // Необязательная таблица транспозиций, может быть общей для нескольких Logic
+    Transposition_table *tt = nullptr;
+    // Память решателя форсированных выигрышей (Proof_search) в мегабайтах, 0 - решатель выключен
+    size_t solver_mb = 0;
+    // Выигрывающая линия последнего доказанного выигрыша (полные ходы, начиная с хода бота)
+    vector<vector<move_pos>> win_line;
+#ifdef CHECKERS_TREE_CAPTURE
+    // Запись дерева поиска, nullptr - не записывать
+    Tree_capture *tree = nullptr;
+#endif
+#ifdef CHECKERS_ALLOC_CHECK
+    size_t last_search_allocs = 0;  // Число выделений памяти за последний поиск (должно быть 0)
+#endif
 
 private:
     default_random_engine rand_eng;  // Генератор случайных чисел
-    string scoring_mode;  // Режим оценки бота
-    string optimization;  // Уровень оптимизации
+    Scoring scoring_mode;  // Режим оценки бота
+    Optimization optimization;  // Уровень оптимизации
+    // Арена поиска: цепочки лучших ходов для состояний с серией взятий
+    static constexpr size_t Arena_capacity = 4096;
     vector<move_pos> next_move;  // Следующий ход
     vector<int> next_best_state;  // Следующее состояние
+    // Пачка листьев для оценки в узлах перед горизонтом
+    static constexpr size_t Leaf_batch = 4;
+    board_mtx leaf_boards[Leaf_batch];
+    double leaf_scores[Leaf_batch];
+    // Решатель форсированных выигрышей, создаётся при первом решающем перевесе
+    static constexpr double Solve_threshold = 1.5;  // Во сколько раз силы бота должны превосходить силы соперника
+    shared_ptr<Proof_search<Draughts_logic>> solver;
+    size_t solver_table_mb = 0;
+    uint64_t unsolved_material = 0;  // Материал позиции, в которой выигрыш в последний раз не доказан
+    // Таблица транспозиций режима MultiPV, создаётся при первом анализе, если tt не задана
+    static constexpr size_t Analysis_tt_mb = 16;
+    shared_ptr<Transposition_table> analysis_tt;
     Board *board;  // Указатель на объект доски
     Config *config;  // Указатель на объект конфигурации
 };
+
+// Русские шашки 8x8 - вариант, на котором работают окно игры, бенчмарк и консольный движок
+using Logic = Draughts_logic<Russian_rules>;
+// Международные шашки 10x10
+using International_logic = Draughts_logic<International_rules>;
@@ -0,0 +1,320 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Logic.h"
+
+using namespace std;
+
+// Сообщение между координатором и рабочим процессом фермы (фиксированный размер, 24 байта)
+struct farm_message
+{
+    enum Type : uint8_t
+    {
+        Assign = 1,  // Координатор -> рабочий: сыграть партию
+        Result = 2,  // Рабочий -> координатор: итог партии
+        Shutdown = 3 // Координатор -> рабочий: завершиться
+    };
+    uint8_t type;
+    uint8_t level[2];  // Assign: уровни ботов белых и чёрных
+    int8_t result;     // Result: 0 - ничья, 1 - победа белых, 2 - победа чёрных
+    uint32_t game;     // Номер партии
+    uint32_t seed;     // Assign: зерно генератора ботов
+    uint16_t turns;    // Assign: предел ходов, Result: сыграно ходов
+    uint16_t pad;
+    uint64_t nodes;    // Result: узлов поиска за партию
+};
+
+// Настройки фермы
+struct farm_settings
+{
+    int games = 100;
+    int workers = 0;        // Рабочих процессов, 0 - по числу ядер
+    int level[2] = {5, 5};  // Уровни ботов белых и чёрных
+    int max_turns = 120;
+    int max_attempts = 3;   // Сколько раз партия переигрывается после падения рабочего
+    int game_timeout_ms = 300000;  // Рабочий, не ответивший за это время, считается зависшим
+};
+
+// Итоги фермы
+struct farm_stats
+{
+    int results[3] = {0, 0, 0};  // Ничьи, победы белых, победы чёрных
+    int failed = 0;              // Партии, на которых рабочий падал max_attempts раз
+    int restarts = 0;            // Перезапущенных рабочих
+    int timeouts = 0;            // Из них зависших
+    uint64_t nodes = 0;
+    uint64_t turns = 0;
+    double ms = 0;
+};
+
+// Ферма партий бот против бота в отдельных процессах.
+// Координатор запускает workers рабочих процессов и связан с каждым парой Unix-сокетов
+// (socketpair). Каждому свободному рабочему отдаётся следующая партия, рабочий играет её
+// однопоточным Logic и отвечает итогом. У процессов нет общего состояния, поэтому они занимают
+// все ядра без блокировок, а падение рабочего не задевает остальных: координатор замечает
+// закрытый сокет или партию дольше game_timeout_ms (зависание), перезапускает процесс
+// и отдаёт его партию заново (до max_attempts раз).
+class Match_farm
+{
+  public:
+    explicit Match_farm(const farm_settings &settings) : settings(settings)
+    {
+        if (this->settings.workers <= 0)
+            this->settings.workers = max(1, int(thread::hardware_concurrency()));
+    }
+
+    farm_stats run()
+    {
+        TRACE_SCOPE("Match_farm::run");
+        const auto start = chrono::steady_clock::now();
+        signal(SIGPIPE, SIG_IGN);  // Запись в сокет упавшего рабочего должна вернуть ошибку, а не убить координатор
+        for (int g = 0; g < settings.games; ++g)
+            pending.push_back(g);
+        attempts.assign(settings.games, 0);
+        workers.resize(settings.workers);
+        for (auto &w : workers)
+            spawn(w);
+
+        vector<pollfd> fds(workers.size());
+        while (finished < settings.games)
+        {
+            for (auto &w : workers)
+                if (w.game == -1 && !pending.empty())
+                    assign(w);
+            for (size_t i = 0; i < workers.size(); ++i)
+                fds[i] = {workers[i].fd, POLLIN, 0};
+            // Ждём ответа не дольше, чем до ближайшего срока партии
+            auto now = chrono::steady_clock::now();
+            auto wake = now + chrono::milliseconds(settings.game_timeout_ms);
+            for (const auto &w : workers)
+                if (w.game != -1)
+                    wake = min(wake, w.deadline);
+            const int timeout = int(chrono::duration_cast<chrono::milliseconds>(wake - now).count()) + 1;
+            if (poll(fds.data(), fds.size(), max(timeout, 0)) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            for (size_t i = 0; i < workers.size(); ++i)
+            {
+                if (!fds[i].revents)
+                    continue;
+                worker &w = workers[i];
+                farm_message msg;
+                if (read_message(w.fd, msg) && msg.type == farm_message::Result && int(msg.game) == w.game)
+                {
+                    ++stats.results[msg.result];
+                    stats.nodes += msg.nodes;
+                    stats.turns += msg.turns;
+                    w.game = -1;
+                    ++finished;
+                    continue;
+                }
+                // Сокет закрыт или сообщение испорчено: рабочий упал, его партия играется заново
+                fail(w);
+            }
+            // Рабочий, не ответивший к сроку, завис (бесконечный цикл, взаимная блокировка)
+            now = chrono::steady_clock::now();
+            for (auto &w : workers)
+            {
+                if (w.game != -1 && now >= w.deadline)
+                {
+                    ++stats.timeouts;
+                    fail(w);
+                }
+            }
+        }
+
+        farm_message bye{};
+        bye.type = farm_message::Shutdown;
+        for (auto &w : workers)
+        {
+            write_message(w.fd, bye);
+            stop(w);
+        }
+        stats.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    int workers_count() const
+    {
+        return settings.workers;
+    }
+
+  private:
+    struct worker
+    {
+        pid_t pid = -1;
+        int fd = -1;    // Сокет координатора
+        int game = -1;  // Партия, которую рабочий сейчас играет
+        chrono::steady_clock::time_point deadline;  // К этому времени партия должна быть сыграна
+    };
+
+    // Перезапускает упавший или зависший рабочий и возвращает его партию в очередь
+    void fail(worker &w)
+    {
+        const int game = w.game;
+        restart(w);
+        if (game == -1)
+            return;
+        if (++attempts[game] < settings.max_attempts)
+            pending.push_front(game);
+        else
+        {
+            ++stats.failed;
+            ++finished;
+        }
+    }
+
+    // Запускает рабочий процесс
+    void spawn(worker &w)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+            throw runtime_error("socketpair failed");
+        const pid_t pid = fork();
+        if (pid < 0)
+            throw runtime_error("fork failed");
+        if (pid == 0)
+        {
+            // Рабочему нужны только свой конец пары, сокеты остальных рабочих закрываются
+            close(sv[0]);
+            for (const auto &other : workers)
+                if (other.fd >= 0)
+                    close(other.fd);
+            _exit(worker_main(sv[1]));
+        }
+        close(sv[1]);
+        w.pid = pid;
+        w.fd = sv[0];
+        w.game = -1;
+    }
+
+    void stop(worker &w)
+    {
+        close(w.fd);
+        waitpid(w.pid, nullptr, 0);
+        w.fd = -1;
+        w.pid = -1;
+    }
+
+    void restart(worker &w)
+    {
+        kill(w.pid, SIGKILL);  // Процесс мог зависнуть с испорченным протоколом
+        stop(w);
+        spawn(w);
+        ++stats.restarts;
+    }
+
+    void assign(worker &w)
+    {
+        const int game = pending.front();
+        pending.pop_front();
+        farm_message msg{};
+        msg.type = farm_message::Assign;
+        msg.level[0] = uint8_t(settings.level[0]);
+        msg.level[1] = uint8_t(settings.level[1]);
+        msg.game = uint32_t(game);
+        msg.seed = uint32_t(game);
+        msg.turns = uint16_t(settings.max_turns);
+        w.game = game;
+        w.deadline = chrono::steady_clock::now() + chrono::milliseconds(settings.game_timeout_ms);
+        // Если запись не удалась, рабочий уже упал: poll сообщит об этом и партия вернётся в очередь
+        write_message(w.fd, msg);
+    }
+
+    // Цикл рабочего процесса: партии по одной, пока не придёт Shutdown или сокет не закроется
+    static int worker_main(const int fd)
+    {
+        farm_message msg;
+        while (read_message(fd, msg) && msg.type == farm_message::Assign)
+        {
+            farm_message res = play(msg);
+            if (!write_message(fd, res))
+                break;
+        }
+        close(fd);
+        return 0;
+    }
+
+    // Партия бот против бота из начальной позиции
+    static farm_message play(const farm_message &task)
+    {
+        Logic logic(Scoring::NumberAndPotential, Optimization::O1, task.seed);
+        board_mtx mtx = Logic::start_mtx();
+
+        farm_message res{};
+        res.type = farm_message::Result;
+        res.game = task.game;
+        int turn = 0;
+        while (true)
+        {
+            const bool color = turn % 2;
+            logic.find_turns(color, mtx);
+            if (turn >= task.turns || logic.turns.empty())
+            {
+                res.result = int8_t(turn >= task.turns ? 0 : (color ? 1 : 2));
+                break;
+            }
+            logic.Max_depth = task.level[color];
+            for (const auto &step : logic.find_best_turns(mtx, color))
+                mtx = Logic::make_turn(mtx, step);
+            res.nodes += logic.nodes;
+            ++turn;
+        }
+        res.turns = uint16_t(turn);
+        return res;
+    }
+
+    static bool read_message(const int fd, farm_message &msg)
+    {
+        char *p = reinterpret_cast<char *>(&msg);
+        size_t done = 0;
+        while (done < sizeof(msg))
+        {
+            const ssize_t n = read(fd, p + done, sizeof(msg) - done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            done += size_t(n);
+        }
+        return msg.type != farm_message::Result || (msg.result >= 0 && msg.result <= 2);
+    }
+
+    static bool write_message(const int fd, const farm_message &msg)
+    {
+        const char *p = reinterpret_cast<const char *>(&msg);
+        size_t done = 0;
+        while (done < sizeof(msg))
+        {
+            const ssize_t n = write(fd, p + done, sizeof(msg) - done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            done += size_t(n);
+        }
+        return true;
+    }
+
+    farm_settings settings;
+    farm_stats stats;
+    int finished = 0;  // Сыгранных и брошенных партий
+    vector<worker> workers;
+    deque<int> pending;    // Партии, ожидающие рабочего
+    vector<int> attempts;  // Сколько раз партия оборвалась падением рабочего
+};
@@ -0,0 +1,446 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Move_list.h"
+#include "Leaf_eval.h"
+#include "Logic.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Бот на поиске по дереву Монте-Карло (MCTS) - альтернатива альфа-бета поиску Logic.
+// Дерево общее для всех потоков (tree parallelism): каждый поток спускается от корня по UCT,
+// раскрывает лист и доигрывает партию до конца быстрыми случайными ходами (playout), а результат
+// поднимает обратно по пути. Статистика узлов - атомарные счётчики без блокировок; чтобы потоки
+// не шли одним и тем же путём, на время спуска узлу добавляется виртуальное поражение.
+// Узлы берутся из заранее выделенного пула (две половины памяти MctsMB): после хода соперника
+// поддерево новой позиции переносится в другую половину, и набранная статистика не теряется.
+// L - вариант Draughts_logic: у каждого потока свой экземпляр для генерации ходов.
+template <class L> class Basic_mcts
+{
+  public:
+    using board_mtx = typename L::board_mtx;
+
+    // Политика доигрывания: Random - равновероятный ход, Light - дамка, если можно, и ход,
+    // после которого соперник ничего не бьёт
+    enum class Playout
+    {
+        Random,
+        Light
+    };
+
+    // memory_mb - память пула узлов, threads - число потоков поиска (0 - по числу ядер)
+    Basic_mcts(const size_t memory_mb, const size_t threads, const unsigned seed, const Playout playout = Playout::Light)
+        : playout_policy(playout), root_logic(Scoring::NumberAndPotential, Optimization::O1, seed)
+    {
+        const size_t count = max<size_t>(threads ? threads : thread::hardware_concurrency(), 1);
+        for (size_t i = 0; i < count; ++i)
+            workers.emplace_back(new worker(seed + 1 + unsigned(i)));
+        const size_t capacity = max<size_t>(memory_mb * (size_t(1) << 20) / 2 / sizeof(node), 1024);
+        for (auto &p : pools)
+        {
+            p.nodes.reset(new node[capacity]);
+            p.capacity = uint32_t(min<size_t>(capacity, UINT32_MAX));
+        }
+    }
+
+    // Лучший полный ход стороны color за время time: ход корня с наибольшим числом посещений
+    vector<move_pos> find_best_turns(const board_mtx &mtx, const bool color, const chrono::milliseconds time)
+    {
+        TRACE_SCOPE("Mcts::search");
+        vector<vector<move_pos>> chains;
+        root_logic.collect_chains(mtx, color, chains);
+        playouts = 0;
+        if (chains.size() <= 1)
+            return chains.empty() ? vector<move_pos>() : chains[0];
+
+        set_root(mtx, color);
+        node &r = root();
+        if (r.state.load(memory_order_relaxed) != Expanded)
+            expand(r, *workers[0]);
+
+        deadline = chrono::steady_clock::now() + time;
+        done = false;
+        vector<thread> threads;
+        for (size_t i = 1; i < workers.size(); ++i)
+            threads.emplace_back(&Basic_mcts::run, this, ref(*workers[i]));
+        run(*workers[0]);
+        for (auto &t : threads)
+            t.join();
+        for (const auto &w : workers)
+            playouts += w->playouts;
+
+        // Ход корня с наибольшим числом посещений
+        const node *best = nullptr;
+        for (uint32_t i = 0; i < r.child_count; ++i)
+        {
+            const node &c = at(r.first_child + i);
+            if (!best || c.visits.load(memory_order_relaxed) > best->visits.load(memory_order_relaxed))
+                best = &c;
+        }
+        if (!best)
+            return chains[0];  // Корень не поместился в пул
+        for (const auto &chain : chains)
+            if (L::apply_chain(mtx, chain) == best->mtx)
+                return chain;
+        return chains[0];
+    }
+
+    size_t playouts = 0;  // Доигрываний за последний поиск
+    size_t reused = 0;    // Узлов, перенесённых из дерева прошлого хода
+    // Флаг отмены поиска, как у Logic
+    const atomic<bool> *stop_flag = nullptr;
+
+  private:
+    // Leaf - раскрыть не удалось (пул заполнен), узел больше не раскрывается и только доигрывается
+    static constexpr uint8_t Unexpanded = 0, Expanding = 1, Expanded = 2, Leaf = 3;
+    static constexpr int32_t Virtual_loss = 3;  // Поражений, добавляемых узлу на время спуска
+    static constexpr int32_t Expand_visits = 4;  // Сколько посещений нужно листу, чтобы его раскрыть
+    static constexpr double Exploration = 1.0;  // Коэффициент исследования в UCT
+    static constexpr int Max_path = 512;
+    static constexpr int Max_playout = 200;  // После стольких полуходов партия оценивается по материалу
+    static constexpr uint32_t No_root = UINT32_MAX;
+
+    // Узел дерева: позиция, сторона хода и статистика для стороны, которая сделала ход в этот узел
+    struct node
+    {
+        board_mtx mtx;
+        bool side;                  // Кто ходит в позиции узла
+        atomic<int32_t> visits;     // Посещения вместе с виртуальными поражениями идущих спусков
+        atomic<int64_t> value;      // Сумма результатов в полуочках: 2 - победа, 1 - ничья
+        atomic<uint8_t> state;      // Unexpanded / Expanding / Expanded / Leaf
+        uint32_t first_child;       // Дети лежат подряд, пишутся до state = Expanded
+        uint32_t child_count;
+    };
+
+    // Половина пула узлов: выделение - атомарный сдвиг счётчика
+    struct pool
+    {
+        unique_ptr<node[]> nodes;
+        uint32_t capacity = 0;
+        atomic<uint32_t> used{0};
+    };
+
+    // Состояние потока поиска
+    struct worker
+    {
+        explicit worker(const unsigned seed) : logic(Scoring::NumberAndPotential, Optimization::O1, seed), rng(seed)
+        {
+        }
+        L logic;
+        mt19937 rng;
+        board_mtx children[move_list::Capacity];  // Позиции детей при раскрытии
+        size_t playouts = 0;
+    };
+
+    node &at(const uint32_t idx)
+    {
+        return pools[cur].nodes[idx];
+    }
+    node &root()
+    {
+        return at(root_idx);
+    }
+
+    // Выделяет count узлов подряд в половине p, возвращает номер первого или No_root, если места нет
+    static uint32_t allocate(pool &p, const uint32_t count)
+    {
+        uint32_t first = p.used.load(memory_order_relaxed);
+        do
+        {
+            if (uint64_t(first) + count > p.capacity)
+                return No_root;
+        } while (!p.used.compare_exchange_weak(first, first + count, memory_order_relaxed));
+        return first;
+    }
+
+    static void init(node &n, const board_mtx &mtx, const bool side)
+    {
+        n.mtx = mtx;
+        n.side = side;
+        n.visits.store(0, memory_order_relaxed);
+        n.value.store(0, memory_order_relaxed);
+        n.state.store(Unexpanded, memory_order_relaxed);
+        n.first_child = 0;
+        n.child_count = 0;
+    }
+
+    // Делает корнем позицию mtx: ищет её среди узлов прошлого дерева на глубине до двух полуходов
+    // (наш ход и ответ соперника) и переносит её поддерево в другую половину пула
+    void set_root(const board_mtx &mtx, const bool color)
+    {
+        uint32_t found = No_root;
+        if (root_idx != No_root)
+        {
+            auto matches = [&](const node &n) { return n.side == color && n.mtx == mtx; };
+            const node &r = root();
+            if (matches(r))
+                found = root_idx;
+            for (uint32_t i = 0; found == No_root && r.child_count && i < r.child_count; ++i)
+            {
+                const node &c = at(r.first_child + i);
+                if (matches(c))
+                    found = r.first_child + i;
+                for (uint32_t j = 0; found == No_root && j < c.child_count; ++j)
+                    if (matches(at(c.first_child + j)))
+                        found = c.first_child + j;
+            }
+        }
+        pool &to = pools[1 - cur];
+        to.used.store(0, memory_order_relaxed);
+        reused = 0;
+        if (found == No_root)
+        {
+            init(to.nodes[allocate(to, 1)], mtx, color);
+        }
+        else
+        {
+            // Обход в ширину: дети каждого перенесённого узла снова ложатся подряд
+            vector<pair<uint32_t, uint32_t>> queue = {{found, allocate(to, 1)}};
+            copy_stats(at(found), to.nodes[0]);
+            for (size_t q = 0; q < queue.size(); ++q)
+            {
+                const node &src = at(queue[q].first);
+                node &dst = to.nodes[queue[q].second];
+                dst.first_child = 0;
+                dst.child_count = 0;
+                if (src.state.load(memory_order_relaxed) != Expanded || !src.child_count)
+                    continue;
+                const uint32_t first = allocate(to, src.child_count);
+                if (first == No_root)
+                {
+                    dst.state.store(Unexpanded, memory_order_relaxed);
+                    continue;
+                }
+                dst.first_child = first;
+                dst.child_count = src.child_count;
+                for (uint32_t i = 0; i < src.child_count; ++i)
+                {
+                    copy_stats(at(src.first_child + i), to.nodes[first + i]);
+                    queue.emplace_back(src.first_child + i, first + i);
+                }
+            }
+            reused = queue.size();
+        }
+        cur = 1 - cur;
+        root_idx = 0;
+    }
+
+    static void copy_stats(const node &src, node &dst)
+    {
+        dst.mtx = src.mtx;
+        dst.side = src.side;
+        dst.visits.store(src.visits.load(memory_order_relaxed), memory_order_relaxed);
+        dst.value.store(src.value.load(memory_order_relaxed), memory_order_relaxed);
+        // В новом пуле есть место, поэтому узел, не поместившийся в старый, снова можно раскрыть
+        const uint8_t state = src.state.load(memory_order_relaxed);
+        dst.state.store(state == Leaf ? Unexpanded : state, memory_order_relaxed);
+    }
+
+    // Раскрывает узел: создаёт детей для всех полных ходов. Вызывает поток, захвативший узел
+    void expand(node &n, worker &w)
+    {
+        size_t count = 0;
+        collect_children(w, n.mtx, n.side, count);
+        const uint32_t first = (count ? allocate(pools[cur], uint32_t(count)) : 0);
+        if (first == No_root)
+        {
+            // Пул заполнен: узел остаётся листом навсегда, иначе каждый следующий спуск
+            // заново генерировал бы его ходы и снова упирался в пул
+            n.state.store(Leaf, memory_order_release);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+            init(at(first + uint32_t(i)), w.children[i], !n.side);
+        n.first_child = first;
+        n.child_count = uint32_t(count);
+        n.state.store(Expanded, memory_order_release);
+    }
+
+    // Позиции после всех полных ходов стороны side (серии взятий целиком)
+    void collect_children(worker &w, const board_mtx &mtx, const bool side, size_t &count)
+    {
+        w.logic.find_turns(side, mtx);
+        const move_list first = w.logic.turns;
+        const bool beats = w.logic.have_beats;
+        for (const auto &turn : first)
+        {
+            if (beats)
+                extend_children(w, L::make_turn(mtx, turn), turn.x2, turn.y2, count);
+            else if (count < move_list::Capacity)
+                w.children[count++] = L::make_turn(mtx, turn);
+        }
+    }
+
+    void extend_children(worker &w, const board_mtx &mtx, const POS_T x, const POS_T y, size_t &count)
+    {
+        w.logic.find_captures(x, y, mtx);
+        if (!w.logic.have_beats)
+        {
+            if (count < move_list::Capacity)
+                w.children[count++] = mtx;
+            return;
+        }
+        const move_list next = w.logic.turns;
+        for (const auto &turn : next)
+            extend_children(w, L::make_turn(mtx, turn), turn.x2, turn.y2, count);
+    }
+
+    // Цикл потока поиска: спуск, раскрытие, доигрывание и обновление статистики до истечения времени
+    void run(worker &w)
+    {
+        w.playouts = 0;
+        uint32_t path[Max_path];
+        while (!done.load(memory_order_relaxed))
+        {
+            // Время проверяется раз в несколько доигрываний
+            if ((w.playouts & 15) == 0 &&
+                (chrono::steady_clock::now() >= deadline || (stop_flag && stop_flag->load(memory_order_relaxed))))
+            {
+                done = true;
+                break;
+            }
+
+            // Спуск по UCT с виртуальными поражениями
+            int len = 0;
+            uint32_t idx = root_idx;
+            path[len++] = idx;
+            while (len < Max_path && at(idx).state.load(memory_order_acquire) == Expanded && at(idx).child_count)
+            {
+                idx = select(at(idx));
+                at(idx).visits.fetch_add(Virtual_loss, memory_order_relaxed);
+                path[len++] = idx;
+            }
+
+            // Раскрытие листа, посещённого достаточно раз; узел захватывает один поток
+            node &leaf = at(idx);
+            uint8_t expected = Unexpanded;
+            if (len < Max_path && leaf.visits.load(memory_order_relaxed) >= Expand_visits &&
+                leaf.state.compare_exchange_strong(expected, Expanding, memory_order_acquire))
+            {
+                expand(leaf, w);
+                if (leaf.child_count)
+                {
+                    idx = leaf.first_child + uint32_t(w.rng() % leaf.child_count);
+                    at(idx).visits.fetch_add(Virtual_loss, memory_order_relaxed);
+                    path[len++] = idx;
+                }
+            }
+
+            const int winner = playout(w, at(idx).mtx, at(idx).side);
+            ++w.playouts;
+
+            // Обновление статистики: виртуальные поражения заменяются настоящим результатом
+            for (int k = 0; k < len; ++k)
+            {
+                node &n = at(path[k]);
+                const bool mover = !n.side;  // Кто сделал ход в этот узел
+                n.value.fetch_add(winner == -1 ? 1 : (winner == int(mover) ? 2 : 0), memory_order_relaxed);
+                n.visits.fetch_add(k == 0 ? 1 : 1 - Virtual_loss, memory_order_relaxed);
+            }
+        }
+    }
+
+    // Ребёнок с наибольшей оценкой UCT: средний результат плюс бонус за малое число посещений
+    uint32_t select(node &n)
+    {
+        const double log_n = log(double(max<int32_t>(n.visits.load(memory_order_relaxed), 1)));
+        uint32_t best = n.first_child;
+        double best_score = -1;
+        for (uint32_t i = 0; i < n.child_count; ++i)
+        {
+            const node &c = at(n.first_child + i);
+            const int32_t visits = c.visits.load(memory_order_relaxed);
+            if (visits <= 0)
+                return n.first_child + i;  // Непосещённые дети выбираются первыми
+            const double q = double(c.value.load(memory_order_relaxed)) / (2.0 * visits);
+            const double score = q + Exploration * sqrt(log_n / visits);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = n.first_child + i;
+            }
+        }
+        return best;
+    }
+
+    // Доигрывает партию из позиции mtx, возвращает победителя (0 - белые, 1 - чёрные) или -1 для ничьей
+    int playout(worker &w, board_mtx mtx, bool side)
+    {
+        L &logic = w.logic;
+        for (int ply = 0; ply < Max_playout; ++ply)
+        {
+            logic.find_turns(side, mtx);
+            if (logic.turns.empty())
+                return !side;  // Ходить нечем - ходящая сторона проиграла
+            if (logic.have_beats)
+            {
+                // Серия взятий случайными ударами до конца
+                move_pos turn = logic.turns[w.rng() % logic.turns.size()];
+                mtx = L::make_turn(mtx, turn);
+                while (true)
+                {
+                    logic.find_captures(turn.x2, turn.y2, mtx);
+                    if (!logic.have_beats)
+                        break;
+                    turn = logic.turns[w.rng() % logic.turns.size()];
+                    mtx = L::make_turn(mtx, turn);
+                }
+            }
+            else
+                mtx = quiet_move(w, mtx, side);
+            side = !side;
+        }
+        // Партия не закончилась: побеждает сторона с большим материалом
+        const auto p = Leaf_eval<L::Geometry::Size>::pack(mtx);
+        const int white = p.men[0] + 3 * p.kings[0], black = p.men[1] + 3 * p.kings[1];
+        return white == black ? -1 : (white > black ? 0 : 1);
+    }
+
+    // Тихий ход доигрывания (ходы стороны уже в logic.turns)
+    board_mtx quiet_move(worker &w, const board_mtx &mtx, const bool side)
+    {
+        L &logic = w.logic;
+        const move_list turns = logic.turns;
+        const size_t n = turns.size();
+        if (playout_policy == Playout::Light)
+        {
+            // Превращение в дамку
+            for (const auto &turn : turns)
+                if (mtx[turn.x][turn.y] == (side ? 2 : 1) && turn.x2 == (side ? L::Geometry::Size - 1 : 0))
+                    return L::make_turn(mtx, turn);
+            // Несколько случайных попыток найти ход, после которого соперник ничего не бьёт
+            for (int attempt = 0; attempt < Light_attempts; ++attempt)
+            {
+                const board_mtx next = L::make_turn(mtx, turns[w.rng() % n]);
+                logic.find_turns(!side, next);
+                if (!logic.have_beats)
+                    return next;
+            }
+        }
+        return L::make_turn(mtx, turns[w.rng() % n]);
+    }
+
+    static constexpr int Light_attempts = 3;
+
+    Playout playout_policy;
+    L root_logic;  // Генерация полных ходов корня
+    vector<unique_ptr<worker>> workers;
+    pool pools[2];
+    int cur = 0;                  // Активная половина пула
+    uint32_t root_idx = No_root;  // Корень в активной половине
+    chrono::steady_clock::time_point deadline;
+    atomic<bool> done{false};
+};
+
+// MCTS для русских шашек 8x8
+using Mcts = Basic_mcts<Logic>;
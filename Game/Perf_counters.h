@@ -0,0 +1,170 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+// Аппаратные счётчики процессора для бенчмарков (perf_event_open, только Linux).
+// Считают такты, инструкции, промахи предсказания переходов и промахи кэшей L1D и последнего уровня
+// в пользовательском коде текущего потока между start() и stop(). Каждое событие открывается отдельно:
+// если процессор, виртуальная машина или perf_event_paranoid не дают какое-то событие, остальные
+// всё равно считаются, а недоступное печатается как n/a. Если счётчики ядро мультиплексирует,
+// значения масштабируются на долю времени, когда счётчик действительно работал.
+class Perf_counters
+{
+  public:
+    enum Event
+    {
+        Cycles,
+        Instructions,
+        Branch_misses,
+        L1d_misses,
+        Llc_misses,
+        Event_count
+    };
+
+    Perf_counters()
+    {
+#ifdef __linux__
+        const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const uint64_t llc_read_miss = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const uint32_t types[Event_count] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                             PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+        const uint64_t configs[Event_count] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                               PERF_COUNT_HW_BRANCH_MISSES, l1d_read_miss, llc_read_miss};
+        for (int e = 0; e < Event_count; ++e)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[e];
+            attr.config = configs[e];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[e] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds[e] < 0 && error.empty())
+                error = strerror(errno);
+        }
+#else
+        error = "not supported on this system";
+#endif
+    }
+
+    Perf_counters(const Perf_counters &) = delete;
+    Perf_counters &operator=(const Perf_counters &) = delete;
+
+    ~Perf_counters()
+    {
+#ifdef __linux__
+        for (const int fd : fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    // Открылось ли хотя бы одно событие
+    bool available() const
+    {
+        for (const int fd : fds)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    // Причина, по которой первое недоступное событие не открылось (пусто, если открылись все)
+    const string &unavailable_reason() const
+    {
+        return error;
+    }
+
+    // Обнуляет и запускает счётчики
+    void start()
+    {
+#ifdef __linux__
+        for (const int fd : fds)
+        {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Останавливает счётчики и читает их значения
+    void stop()
+    {
+#ifdef __linux__
+        for (int e = 0; e < Event_count; ++e)
+        {
+            values[e] = -1;
+            if (fds[e] < 0)
+                continue;
+            ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3];  // Значение, время включения, время работы
+            if (read(fds[e], data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+                continue;
+            values[e] = double(data[0]) * double(data[1]) / double(data[2]);
+        }
+#endif
+    }
+
+    // Значение события за последний замер, -1 - событие недоступно
+    double value(const Event e) const
+    {
+        return values[e];
+    }
+
+    // Печатает счётчики, IPC и средние на единицу работы (per - число узлов, ходов и т.п.)
+    void report(ostream &out, const double per, const char *unit) const
+    {
+        if (!available())
+        {
+            out << "HW counters     : unavailable (" << error << ")\n";
+            return;
+        }
+        static const char *const names[Event_count] = {"Cycles          : ", "Instructions    : ",
+                                                      "Branch misses   : ", "L1D read misses : ",
+                                                      "LLC read misses : "};
+        const auto old_flags = out.flags();
+        const auto old_precision = out.precision();
+        out << fixed << setprecision(2);
+        for (int e = 0; e < Event_count; ++e)
+        {
+            out << names[e];
+            if (values[e] < 0)
+            {
+                out << "n/a\n";
+                continue;
+            }
+            out << (long long)values[e];
+            if (per > 0)
+                out << " (" << values[e] / per << " per " << unit << ")";
+            out << "\n";
+        }
+        if (values[Cycles] > 0 && values[Instructions] >= 0)
+            out << "IPC             : " << values[Instructions] / values[Cycles] << "\n";
+        out.flags(old_flags);
+        out.precision(old_precision);
+    }
+
+  private:
+    int fds[Event_count] = {-1, -1, -1, -1, -1};
+    double values[Event_count] = {-1, -1, -1, -1, -1};
+    string error;
+};
@@ -0,0 +1,330 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Move_list.h"
+#include "Transposition_table.h"
+
+using namespace std;
+
+// Поиск по числам доказательства (df-pn) для доказательства форсированного выигрыша.
+// Дерево И/ИЛИ: в узлах ИЛИ ходит атакующая сторона (достаточно одного выигрывающего хода),
+// в узлах И - защищающаяся (выигрыш нужен после любого ответа). Для узла хранятся число
+// доказательства pn и число опровержения dn - сколько листьев ещё нужно решить, чтобы доказать
+// или опровергнуть выигрыш. Поиск в глубину с порогами всегда раскрывает самый доказуемый узел,
+// а числа узлов держит в таблице фиксированного размера. Арена детей узлов пути тоже берётся из бюджета
+// и не растёт: если она заполнилась, поиск заканчивается с результатом Unknown, поэтому вся память
+// решателя ограничена бюджетом.
+// Выигрыш - у соперника нет ходов. Повтор позиции на текущем пути и превышение Max_ply считаются
+// невыигрышем: это может лишь скрыть выигрыш, но не создать ложный.
+// L - вариант Draughts_logic, через который генерируются ходы.
+template <class L> class Proof_search
+{
+  public:
+    using board_mtx = typename L::board_mtx;
+
+    enum class Result
+    {
+        Win,     // Выигрыш доказан
+        No_win,  // Выигрыша нет (в пределах Max_ply)
+        Unknown  // Бюджет узлов исчерпан или поиск отменён
+    };
+
+    // memory_mb - память решателя: восьмая часть на арену детей, остальное - таблица чисел доказательства
+    explicit Proof_search(const size_t memory_mb)
+    {
+        const size_t bytes = memory_mb * (size_t(1) << 20);
+        arena_capacity = max(Arena_min, bytes / 8 / sizeof(child));
+        const size_t table_bytes = bytes - min(bytes, arena_capacity * sizeof(child));
+        size_t slots = 1024;
+        while (slots * 2 * sizeof(entry) <= table_bytes)
+            slots *= 2;
+        table.resize(slots);
+        arena.reserve(arena_capacity);
+        path.reserve(Max_ply + 1);
+    }
+
+    // Слотов в таблице чисел доказательства
+    size_t table_slots() const
+    {
+        return table.size();
+    }
+
+    // Доказывает выигрыш стороны color из позиции mtx, раскрывая не больше max_nodes узлов.
+    // При Win в line - выигрывающая линия из полных ходов, начиная с хода color.
+    // Таблица сохраняется между вызовами, поэтому следующий ход выигранной партии доказывается сразу
+    Result solve(L &logic, const board_mtx &mtx, const bool color, const size_t max_nodes,
+                 vector<vector<move_pos>> &line)
+    {
+        this->logic = &logic;
+        attacker = color;
+        nodes = 0;
+        node_limit = max_nodes;
+        arena.clear();
+        arena_full = false;
+        path.clear();
+        const uint64_t root_key = key(mtx, color);
+        mid(mtx, color, root_key, false, 0, Inf, Inf);
+
+        const entry root = lookup(root_key);
+        if (arena_full && root.pn != 0)
+            return Result::Unknown;
+        if (root.dn == 0)
+            return Result::No_win;
+        if (root.pn != 0)
+            return Result::Unknown;
+        line.clear();
+        extract_line(mtx, line);
+        // Если доказательство частично вытеснено из таблицы, первого хода не восстановить
+        return line.empty() ? Result::Unknown : Result::Win;
+    }
+
+    size_t nodes = 0;  // Узлов раскрыто за последний вызов
+
+  private:
+    static constexpr uint32_t Inf = 1u << 30;  // Бесконечное число доказательства или опровержения
+    static constexpr int Max_ply = 200;        // Глубже выигрыш не ищется
+    static constexpr int Max_chain = 32;       // Самая длинная серия взятий одной фигуры
+    static constexpr size_t Arena_min = 1024;  // Наименьшая арена: с запасом больше детей одного узла
+    // Подмешивается в ключ, когда атакуют чёрные: числа узла зависят от того, кто доказывает выигрыш
+    static constexpr uint64_t Black_attacker = 0x9E3779B97F4A7C15ull;
+
+    // Слот таблицы. Пустой слот (ключ 0) читается как нерешённый узел
+    struct entry
+    {
+        uint64_t key;
+        uint32_t pn, dn;
+    };
+
+    // Один удар или тихий ход (move_pos без конструктора по умолчанию, чтобы храниться в массиве)
+    struct step
+    {
+        POS_T x, y, x2, y2, xb, yb;
+    };
+
+    // Ребёнок узла: позиция после полного хода и сам ход
+    struct child
+    {
+        board_mtx mtx;
+        uint64_t key;
+        bool irreversible;  // Ход простой или со взятием: прежние позиции больше не повторятся
+        int len;
+        step chain[Max_chain];
+    };
+
+    uint64_t key(const board_mtx &mtx, const bool side) const
+    {
+        return position_key<L::Geometry::Size>(mtx) ^ L::zobrist.side[side] ^ (attacker ? Black_attacker : 0);
+    }
+
+    // Числа узла из таблицы, для нерешённого и вытесненного узла - (1, 1)
+    entry lookup(const uint64_t k) const
+    {
+        const entry &e = table[k & (table.size() - 1)];
+        return e.key == k ? e : entry{k, 1, 1};
+    }
+
+    // Решённые узлы не вытесняются нерешёнными
+    void store(const uint64_t k, const uint32_t pn, const uint32_t dn)
+    {
+        entry &e = table[k & (table.size() - 1)];
+        if (e.key != k && e.key != 0 && (e.pn == 0 || e.dn == 0) && pn != 0 && dn != 0)
+            return;
+        e = {k, pn, dn};
+    }
+
+    // Позиция повторяет одну из позиций текущего пути (после последнего необратимого хода)
+    bool repeated(const child &c) const
+    {
+        if (c.irreversible)
+            return false;
+        for (auto it = path.rbegin(); it != path.rend(); ++it)
+        {
+            if (it->key == c.key)
+                return true;
+            if (it->irreversible)
+                break;
+        }
+        return false;
+    }
+
+    // Раскрывает узел, пока его числа не выйдут за пороги th_pn, th_dn, и записывает их в таблицу
+    void mid(const board_mtx &mtx, const bool side, const uint64_t k, const bool irreversible, const int ply,
+             const uint32_t th_pn, const uint32_t th_dn)
+    {
+        ++nodes;
+        const bool or_node = (side == attacker);
+        const size_t first = arena.size();
+        expand(mtx, side);
+        const size_t last = arena.size();
+        if (arena_full)
+        {
+            // Узел раскрыт не полностью, его числа были бы неверны: поиск сворачивается
+            arena.resize(first);
+            return;
+        }
+        if (first == last)
+        {
+            // Ходить нечем: ходящая сторона проиграла
+            store(k, or_node ? Inf : 0, or_node ? 0 : Inf);
+            return;
+        }
+        if (ply >= Max_ply)
+        {
+            store(k, Inf, 0);
+            arena.resize(first);
+            return;
+        }
+
+        path.push_back({k, irreversible});
+        while (true)
+        {
+            // Числа узла по числам детей: в ИЛИ pn - минимум, dn - сумма, в И наоборот
+            uint64_t sum = 0;
+            uint32_t best_value = Inf + 1, second = Inf;
+            size_t best = first;
+            entry best_entry{};
+            for (size_t i = first; i < last; ++i)
+            {
+                entry e = lookup(arena[i].key);
+                if (repeated(arena[i]))
+                    e.pn = Inf, e.dn = 0;
+                const uint32_t v = (or_node ? e.pn : e.dn);
+                sum += (or_node ? e.dn : e.pn);
+                if (v < best_value)
+                {
+                    second = best_value;
+                    best_value = v;
+                    best = i;
+                    best_entry = e;
+                }
+                else if (v < second)
+                    second = v;
+            }
+            const uint32_t total = uint32_t(min<uint64_t>(sum, Inf));
+            const uint32_t pn = (or_node ? best_value : total);
+            const uint32_t dn = (or_node ? total : best_value);
+            if (pn >= th_pn || dn >= th_dn || nodes >= node_limit || arena_full || logic->stopped())
+            {
+                store(k, pn, dn);
+                break;
+            }
+            // Пороги ребёнка: он раскрывается, пока остаётся лучшим и узел не выходит за свои пороги
+            uint32_t child_pn, child_dn;
+            if (or_node)
+            {
+                child_pn = min(th_pn, second + 1);
+                child_dn = uint32_t(min<uint64_t>(uint64_t(th_dn) - dn + best_entry.dn, Inf));
+            }
+            else
+            {
+                child_dn = min(th_dn, second + 1);
+                child_pn = uint32_t(min<uint64_t>(uint64_t(th_pn) - pn + best_entry.pn, Inf));
+            }
+            // Арена растёт во время раскрытия ребёнка, поэтому позиция копируется
+            const child c = arena[best];
+            mid(c.mtx, !side, c.key, c.irreversible, ply + 1, child_pn, child_dn);
+        }
+        path.pop_back();
+        arena.resize(first);
+    }
+
+    // Добавляет в арену все полные ходы стороны side (серии взятий целиком)
+    void expand(const board_mtx &mtx, const bool side)
+    {
+        logic->find_turns(side, mtx);
+        const move_list first = logic->turns;
+        const bool beats = logic->have_beats;
+        child c;
+        for (const auto &turn : first)
+        {
+            c.len = 1;
+            c.chain[0] = {turn.x, turn.y, turn.x2, turn.y2, turn.xb, turn.yb};
+            c.irreversible = beats || mtx[turn.x][turn.y] <= 2;
+            if (beats)
+                extend(L::make_turn(mtx, turn), side, c);
+            else
+                push(L::make_turn(mtx, turn), side, c);
+        }
+    }
+
+    // Продолжает серию взятий c всеми способами
+    void extend(const board_mtx &mtx, const bool side, child &c)
+    {
+        const step &last = c.chain[c.len - 1];
+        logic->find_captures(last.x2, last.y2, mtx);
+        if (!logic->have_beats || c.len == Max_chain)
+        {
+            push(mtx, side, c);
+            return;
+        }
+        const move_list next = logic->turns;
+        for (const auto &turn : next)
+        {
+            c.chain[c.len++] = {turn.x, turn.y, turn.x2, turn.y2, turn.xb, turn.yb};
+            extend(L::make_turn(mtx, turn), side, c);
+            --c.len;
+        }
+    }
+
+    void push(const board_mtx &mtx, const bool side, child &c)
+    {
+        if (arena.size() == arena_capacity)
+        {
+            arena_full = true;
+            return;
+        }
+        c.mtx = mtx;
+        c.key = key(mtx, !side);
+        arena.push_back(c);
+    }
+
+    // Выигрывающая линия по доказанным узлам: атакующий выбирает доказанный ход,
+    // защищающийся - первый ответ (все его ответы доказаны)
+    void extract_line(board_mtx mtx, vector<vector<move_pos>> &line)
+    {
+        bool side = attacker;
+        for (int ply = 0; ply < Max_ply; ++ply)
+        {
+            arena.clear();
+            expand(mtx, side);
+            const child *next = nullptr;
+            for (const auto &c : arena)
+            {
+                if (lookup(c.key).pn == 0)
+                {
+                    next = &c;
+                    break;
+                }
+            }
+            if (!next)
+                return;
+            vector<move_pos> full_move;
+            for (int i = 0; i < next->len; ++i)
+            {
+                const step &t = next->chain[i];
+                full_move.emplace_back(t.x, t.y, t.x2, t.y2, t.xb, t.yb);
+            }
+            line.push_back(full_move);
+            mtx = next->mtx;
+            side = !side;
+        }
+    }
+
+    struct path_item
+    {
+        uint64_t key;
+        bool irreversible;
+    };
+
+    L *logic = nullptr;
+    bool attacker = false;  // Сторона, выигрыш которой доказывается
+    size_t node_limit = 0;
+    vector<entry> table;
+    vector<child> arena;      // Дети всех узлов текущего пути, как стек
+    size_t arena_capacity = 0;  // Предел арены, она не растёт дальше зарезервированного
+    bool arena_full = false;    // Арена заполнилась в текущем вызове solve
+    vector<path_item> path;   // Позиции текущего пути для поиска повторов
+};
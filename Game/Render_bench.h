@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Board.h"
+#include "Logic.h"
+
+// Бенчмарк отрисовки без дисплея.
+// SDL запускается с видеодрайвером dummy и программным рендерером, поэтому бенчмарк работает на
+// сборочных машинах без экрана и видеокарты. Доска проходит сценарий: партии случайными ходами
+// (с подсветкой фигур, выбором клетки, анимацией и полосой хода поиска), изменения размера окна
+// и экраны результата. Сценарий идёт в своём потоке, как поток игры, а цикл окна в главном потоке
+// замеряет каждый кадр (render_timings); после остановки печатаются процентили времени кадра
+// и показа, время пересчёта разметки и загрузки атласа.
+class Render_bench
+{
+  public:
+    // moves - сколько ходов сыграть в сценарии. Возвращает 1, если SDL не запустился
+    int run(const int moves) const
+    {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        render_timings timings;
+        timings.frame.reserve(Reserve_frames);
+        timings.present.reserve(Reserve_frames);
+        const auto start = chrono::steady_clock::now();
+        {
+            Board board(Sizes[0], Sizes[0]);
+            board.timings = &timings;
+            if (board.start_draw())
+            {
+                cout << "Can't start SDL with the dummy video driver and software renderer, see log.txt" << endl;
+                return 1;
+            }
+            thread script([&board, moves] {
+                play_script(board, moves);
+                board.stop();
+            });
+            board.run();
+            script.join();
+        }  // Цикл окна завершён, замеры можно читать
+        const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        cout << "Scripted moves  : " << moves << " in " << (long long)ms << " ms\n";
+        cout << "Frames          : " << timings.frame.size() << "\n";
+        cout << "Atlas load (us) : " << (long long)timings.atlas_load << "\n";
+        print_stats("Frame (us)      : ", timings.frame);
+        print_stats("Present (us)    : ", timings.present);
+        print_stats("Resize (us)     : ", timings.resize);
+        cout.flush();
+        return 0;
+    }
+
+  private:
+    static constexpr unsigned Sizes[] = {800, 600, 1000, 480};  // Размеры окна, по кругу
+    static constexpr int Resize_every = 16;                     // Ходов между изменениями размера
+    static constexpr auto Step_time = chrono::milliseconds(20);  // Пауза после шага, чтобы кадр успел нарисоваться
+    static constexpr size_t Reserve_frames = 1 << 16;
+
+    // Сценарий: случайные партии, пока не сыграно moves ходов
+    static void play_script(Board &board, const int moves)
+    {
+        Logic logic(Scoring::NumberAndPotential, Optimization::O1, 0);
+        mt19937 rng(0);
+        int color = 0, size_idx = 0;
+        for (int move = 0; move < moves; ++move)
+        {
+            const auto mtx = Logic::to_mtx(board.get_board());
+            logic.find_turns(color, mtx);
+            if (logic.turns.empty() || board.history_mtx.size() > Max_game_moves)
+            {
+                // Конец партии: экран результата, потом новая партия
+                board.show_final(logic.turns.empty() ? (color ? 1 : 2) : 0);
+                step();
+                board.redraw();
+                color = 0;
+                continue;
+            }
+
+            // Игрок выбирает фигуру: подсветка всех фигур с ходами, затем активная клетка
+            vector<pair<POS_T, POS_T>> cells;
+            for (const auto &turn : logic.turns)
+                cells.emplace_back(turn.x, turn.y);
+            board.highlight_cells(cells);
+            step();
+            move_pos turn = logic.turns[rng() % logic.turns.size()];
+            board.clear_highlight();
+            board.set_active(turn.x, turn.y);
+            board.show_progress(0.5);
+            step();
+            board.show_progress(-1);
+            board.clear_active();
+
+            // Ход целиком, серия взятий - прыжок за прыжком
+            int beat_series = 0;
+            while (true)
+            {
+                beat_series += (turn.xb != -1);
+                board.move_piece(turn, beat_series);
+                if (turn.xb == -1)
+                    break;
+                logic.find_turns(turn.x2, turn.y2, Logic::to_mtx(board.get_board()));
+                if (!logic.have_beats)
+                    break;
+                turn = logic.turns[rng() % logic.turns.size()];
+            }
+            step();
+            color = !color;
+
+            if ((move + 1) % Resize_every == 0)
+            {
+                size_idx = (size_idx + 1) % int(size(Sizes));
+                board.set_window_size(int(Sizes[size_idx]), int(Sizes[size_idx]));
+                step();
+            }
+        }
+    }
+
+    static constexpr size_t Max_game_moves = 120;
+
+    static void step()
+    {
+        this_thread::sleep_for(Step_time);
+    }
+
+    // Печатает p50 / p90 / p99 / max и среднее
+    static void print_stats(const char *title, vector<float> v)
+    {
+        cout << title;
+        if (v.empty())
+        {
+            cout << "no samples\n";
+            return;
+        }
+        sort(v.begin(), v.end());
+        auto pct = [&v](const double p) { return (long long)v[min(v.size() - 1, size_t(p * v.size()))]; };
+        double sum = 0;
+        for (const float x : v)
+            sum += x;
+        cout << "p50 " << pct(0.5) << ", p90 " << pct(0.9) << ", p99 " << pct(0.99) << ", max " << (long long)v.back()
+             << ", mean " << (long long)(sum / v.size()) << " (" << v.size() << " calls)\n";
+    }
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+// Варианты правил, которыми параметризуется Draughts_logic.
+// Каждый вариант компилируется в отдельную специализацию поиска с постоянными границами доски.
+
+// Русские шашки: доска 8x8, серию взятий можно выбрать любую,
+// простая, дошедшая до последней горизонтали во время взятия, сразу бьёт дальше как дамка
+struct Russian_rules
+{
+    static constexpr int Size = 8;                      // Размер стороны доски
+    static constexpr int Start_rows = 3;                // Рядов фигур у каждой стороны в начале
+    static constexpr bool Majority_capture = false;     // Обязательно ли брать наибольшее число фигур
+    static constexpr bool Promote_during_capture = true;  // Превращается ли простая в дамку посреди серии
+    static constexpr bool Captured_stay_until_end = false;  // Остаются ли взятые фигуры на доске до конца серии
+};
+
+// Международные шашки: доска 10x10, обязательна серия с наибольшим числом взятых фигур,
+// простая становится дамкой, только если заканчивает ход на последней горизонтали.
+// Взятые фигуры снимаются после окончания серии: до того через них нельзя пройти и их нельзя бить второй раз
+struct International_rules
+{
+    static constexpr int Size = 10;
+    static constexpr int Start_rows = 4;
+    static constexpr bool Majority_capture = true;
+    static constexpr bool Promote_during_capture = false;
+    static constexpr bool Captured_stay_until_end = true;
+};
@@ -0,0 +1,288 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Logic.h"
+#include "Thread_pool.h"
+
+using namespace std;
+
+// Позиция с разметкой в файле обучающих данных (20 байт)
+struct self_play_record
+{
+    uint8_t cells[12];  // 32 игровые клетки по 3 бита: 0 - пусто, 1..4 - фигура как в board_mtx
+    float score;        // Оценка поиска для стороны хода (отношение материала, INF - доказанный выигрыш)
+    uint8_t color;      // Сторона хода: 0 - белые, 1 - чёрные
+    uint8_t result;     // Итог партии: 0 - ничья, 1 - победа белых, 2 - победа чёрных
+    uint8_t ply;        // Номер хода в партии (не больше 255)
+    uint8_t pad;
+};
+static_assert(sizeof(self_play_record) == 20, "self_play_record layout");
+static_assert(Geometry::Cells * 3 <= 8 * sizeof(self_play_record::cells), "cells do not fit");
+
+// Заголовок файла-шарда
+struct self_play_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t board_size;
+    uint32_t count;  // Записей в шарде
+};
+
+// Настройки генератора
+struct self_play_settings
+{
+    int games = 1000;
+    size_t threads = 0;         // Потоков с партиями, 0 - по числу ядер
+    int depth[2] = {4, 4};      // Глубина поиска белых и чёрных
+    int random_plies = 6;       // Первые ходы партии делаются случайно, чтобы партии расходились
+    int max_turns = 120;        // После этого партия - ничья
+    unsigned seed = 0;          // Зерно партии i - seed + i
+    string dir = "selfplay";    // Каталог шардов
+    size_t shard_records = 1 << 20;  // Записей в одном шарде
+};
+
+// Итоги генератора
+struct self_play_stats
+{
+    int results[3] = {0, 0, 0};  // Ничьи, победы белых, победы чёрных
+    size_t positions = 0;        // Позиций во всех партиях
+    size_t written = 0;          // Записано уникальных позиций
+    size_t duplicates = 0;       // Отброшено повторов
+    size_t shards = 0;
+    double ms = 0;
+};
+
+// Генератор обучающих данных партиями Logic против Logic.
+// Партии играются задачами в Thread_pool, у каждой свой Logic со своим зерном. Для каждого хода
+// запоминаются позиция, оценка поиска и сторона хода, после конца партии к ним добавляется итог.
+// Готовая партия целиком отдаётся писателю: очередь без ограничения длины и под мьютексом только
+// перенос вектора, поэтому потоки партий не ждут диска. Поток писателя отбрасывает позиции, чей
+// ключ Zobrist (с учётом стороны хода) уже встречался, упаковывает доску по 3 бита на клетку
+// и пишет шарды по shard_records записей фиксированного размера. Шард пишется во временный файл
+// и переименовывается после записи заголовка, так что в каталоге видны только целые шарды.
+class Self_play
+{
+  public:
+    static constexpr uint32_t Version = 1;
+
+    explicit Self_play(const self_play_settings &settings) : settings(settings)
+    {
+        if (this->settings.threads == 0)
+            this->settings.threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    // Играет все партии и ждёт записи всех шардов
+    self_play_stats run()
+    {
+        TRACE_SCOPE("Self_play::run");
+        const auto start = chrono::steady_clock::now();
+        error_code ec;
+        filesystem::create_directories(settings.dir, ec);
+        thread writer(&Self_play::write_loop, this);
+        {
+            Thread_pool pool(settings.threads);
+            for (int i = 0; i < settings.games; ++i)
+                pool.submit([this, i] { submit(play(unsigned(settings.seed + i))); });
+        }  // Деструктор пула дожидается всех партий
+        {
+            lock_guard<mutex> lock(queue_mtx);
+            done = true;
+        }
+        queue_cv.notify_one();
+        writer.join();
+        stats.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    size_t threads_count() const
+    {
+        return settings.threads;
+    }
+
+    // Распаковывает доску записи
+    static board_mtx unpack(const self_play_record &r)
+    {
+        board_mtx mtx{};
+        for (int idx = 0; idx < Geometry::Cells; ++idx)
+        {
+            const int bit = idx * 3;
+            const int v = ((r.cells[bit / 8] | (bit / 8 + 1 < 12 ? r.cells[bit / 8 + 1] << 8 : 0)) >> (bit % 8)) & 7;
+            mtx[geometry.cell[idx].x][geometry.cell[idx].y] = POS_T(v);
+        }
+        return mtx;
+    }
+
+  private:
+    // Позиция партии до упаковки
+    struct position
+    {
+        uint64_t key;
+        board_mtx mtx;
+        float score;
+        uint8_t color;
+        uint8_t ply;
+    };
+
+    struct game_record
+    {
+        vector<position> positions;
+        uint8_t result = 0;
+    };
+
+    game_record play(const unsigned seed) const
+    {
+        Logic logic(Scoring::NumberAndPotential, Optimization::O1, seed);
+        mt19937 rng(seed);
+        game_record game;
+        game.positions.reserve(settings.max_turns);
+        board_mtx mtx = Logic::start_mtx();
+        int turn = 0;
+        while (true)
+        {
+            const bool color = turn % 2;
+            logic.find_turns(color, mtx);
+            if (turn >= settings.max_turns || logic.turns.empty())
+            {
+                game.result = uint8_t(turn >= settings.max_turns ? 0 : (color ? 1 : 2));
+                break;
+            }
+            logic.Max_depth = settings.depth[color];
+            vector<move_pos> chain = logic.find_best_turns(mtx, color);
+            game.positions.push_back({position_key<Geometry::Size>(mtx) ^ Logic::zobrist.side[color], mtx,
+                                      float(logic.score), uint8_t(color), uint8_t(min(turn, 255))});
+            if (turn < settings.random_plies)
+                chain = random_chain(logic, mtx, color, rng);
+            for (const auto &step : chain)
+                mtx = Logic::make_turn(mtx, step);
+            ++turn;
+        }
+        return game;
+    }
+
+    // Случайный полный ход: случайный ход корня, серия взятий продолжается случайными ударами
+    static vector<move_pos> random_chain(Logic &logic, board_mtx mtx, const bool color, mt19937 &rng)
+    {
+        vector<move_pos> chain;
+        logic.find_turns(color, mtx);
+        while (!logic.turns.empty())
+        {
+            const move_pos turn = logic.turns[rng() % logic.turns.size()];
+            chain.push_back(turn);
+            if (turn.xb == -1)
+                break;
+            mtx = Logic::make_turn(mtx, turn);
+            logic.find_captures(turn.x2, turn.y2, mtx);
+            if (!logic.have_beats)
+                break;
+        }
+        return chain;
+    }
+
+    void submit(game_record &&game)
+    {
+        {
+            lock_guard<mutex> lock(queue_mtx);
+            queue.push_back(move(game));
+        }
+        queue_cv.notify_one();
+    }
+
+    void write_loop()
+    {
+        deque<game_record> batch;
+        while (true)
+        {
+            {
+                unique_lock<mutex> lock(queue_mtx);
+                queue_cv.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty())
+                    break;
+                batch.swap(queue);
+            }
+            for (const auto &game : batch)
+            {
+                ++stats.results[game.result];
+                for (const auto &p : game.positions)
+                    store(p, game.result);
+            }
+            batch.clear();
+        }
+        close_shard();
+    }
+
+    void store(const position &p, const uint8_t result)
+    {
+        ++stats.positions;
+        if (!seen.insert(p.key).second)
+        {
+            ++stats.duplicates;
+            return;
+        }
+        if (shard.size() == settings.shard_records)
+            close_shard();
+        self_play_record r{};
+        for (int idx = 0; idx < Geometry::Cells; ++idx)
+        {
+            const int bit = idx * 3;
+            const unsigned v = unsigned(p.mtx[geometry.cell[idx].x][geometry.cell[idx].y]) << (bit % 8);
+            r.cells[bit / 8] |= uint8_t(v);
+            if (v >> 8)
+                r.cells[bit / 8 + 1] |= uint8_t(v >> 8);
+        }
+        r.score = p.score;
+        r.color = p.color;
+        r.result = result;
+        r.ply = p.ply;
+        shard.push_back(r);
+    }
+
+    void close_shard()
+    {
+        if (shard.empty())
+            return;
+        char name[32];
+        snprintf(name, sizeof(name), "shard_%05zu.bin", stats.shards);
+        const filesystem::path path = filesystem::path(settings.dir) / name;
+        const filesystem::path tmp = filesystem::path(path).concat(".tmp");
+        self_play_header header = {{'C', 'H', 'K', 'R', 'S', 'P', 'D', 0}, Version, sizeof(self_play_record),
+                                   uint32_t(Geometry::Size), uint32_t(shard.size())};
+        FILE *f = fopen(tmp.string().c_str(), "wb");
+        bool ok = f && fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  fwrite(shard.data(), sizeof(self_play_record), shard.size(), f) == shard.size();
+        if (f)
+            ok = (fclose(f) == 0) && ok;
+        error_code ec;
+        if (ok)
+            filesystem::rename(tmp, path, ec);
+        if (ok && !ec)
+        {
+            stats.written += shard.size();
+            ++stats.shards;
+        }
+        shard.clear();
+    }
+
+    self_play_settings settings;
+    self_play_stats stats;  // Меняется только потоком писателя до его завершения
+
+    mutex queue_mtx;  // Защищает queue и done
+    condition_variable queue_cv;
+    deque<game_record> queue;  // Сыгранные партии, ожидающие записи
+    bool done = false;
+
+    // Состояние потока писателя
+    unordered_set<uint64_t> seen;  // Ключи уже записанных позиций
+    vector<self_play_record> shard;
+};
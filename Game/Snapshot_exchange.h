@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+
+// Обмен снимками состояния между одним писателем и одним читателем без блокировок (тройной буфер).
+// Писатель заполняет свой буфер и меняет его местами со средним, читатель забирает средний буфер,
+// если там появился новый снимок. Ни одна сторона не ждёт другую и не выделяет память;
+// промежуточные снимки могут пропускаться, читатель всегда получает самый свежий.
+template <class T> class Snapshot_exchange
+{
+  public:
+    // Буфер писателя. Его содержимое после publish не определено, поэтому снимок заполняется целиком
+    T &back()
+    {
+        return slots[back_idx];
+    }
+
+    // Делает заполненный буфер писателя доступным читателю
+    void publish()
+    {
+        back_idx = middle.exchange(back_idx | Fresh, std::memory_order_acq_rel) & Index_mask;
+    }
+
+    // Забирает свежий снимок, если он появился. Возвращает true, если front() обновился
+    bool take()
+    {
+        if (!(middle.load(std::memory_order_acquire) & Fresh))
+            return false;
+        front_idx = middle.exchange(front_idx, std::memory_order_acq_rel) & Index_mask;
+        return true;
+    }
+
+    // Последний забранный читателем снимок
+    const T &front() const
+    {
+        return slots[front_idx];
+    }
+
+  private:
+    static constexpr int Index_mask = 3;  // Номер буфера в middle
+    static constexpr int Fresh = 4;       // Флаг: в среднем буфере снимок, который читатель ещё не видел
+
+    T slots[3]{};
+    int back_idx = 0;   // Принадлежит писателю
+    int front_idx = 1;  // Принадлежит читателю
+    std::atomic<int> middle{2};
+};
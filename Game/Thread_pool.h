@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing).
+// У каждого рабочего потока своя очередь. Задачи снаружи раскладываются по очередям по кругу,
+// задачи из рабочего потока кладутся в его собственную очередь. Поток берёт самую старую задачу
+// своей очереди (FIFO, чтобы ранние запросы не голодали), а опустевший поток забирает
+// самую новую задачу из хвоста чужой очереди.
+class Thread_pool
+{
+  public:
+    explicit Thread_pool(size_t threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max<size_t>(threads, 1);
+        for (size_t i = 0; i < threads; ++i)
+            queues.emplace_back(new worker_queue);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back(&Thread_pool::run, this, i);
+    }
+
+    Thread_pool(const Thread_pool &) = delete;
+    Thread_pool &operator=(const Thread_pool &) = delete;
+
+    ~Thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+            done = true;
+        }
+        sleep_cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    // Добавляет задачу в пул
+    void submit(std::function<void()> task)
+    {
+        const worker_tag &tag = current_worker();
+        const size_t id = (tag.pool == this ? tag.id : next_queue++ % queues.size());
+        {
+            std::lock_guard<std::mutex> lock(queues[id]->mtx);
+            queues[id]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+            ++pending;
+        }
+        sleep_cv.notify_one();
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+  private:
+    struct worker_queue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Пул и номер рабочего потока, которому принадлежит текущий поток
+    struct worker_tag
+    {
+        const Thread_pool *pool = nullptr;
+        size_t id = 0;
+    };
+
+    static worker_tag &current_worker()
+    {
+        thread_local worker_tag tag;
+        return tag;
+    }
+
+    void run(const size_t id)
+    {
+        current_worker() = {this, id};
+        std::function<void()> task;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(sleep_mtx);
+                sleep_cv.wait(lock, [this] { return done || pending > 0; });
+                if (done && pending == 0)
+                    return;
+                --pending;
+            }
+            // Задача гарантированно есть в одной из очередей: ищем её, начиная со своей
+            while (!pop(id, task))
+                std::this_thread::yield();
+            task();
+            task = nullptr;  // Освобождаем захваченные задачей данные сразу
+        }
+    }
+
+    bool pop(const size_t id, std::function<void()> &task)
+    {
+        {
+            worker_queue &own = *queues[id];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            worker_queue &other = *queues[(id + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(other.mtx);
+            if (!other.tasks.empty())
+            {
+                task = std::move(other.tasks.back());
+                other.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_queue{0};
+
+    std::mutex sleep_mtx;
+    std::condition_variable sleep_cv;
+    size_t pending = 0;  // Количество задач в очередях, защищено sleep_mtx
+    bool done = false;
+};
@@ -0,0 +1,122 @@
+#pragma once
+// Профилирование по шкале времени в формате Chrome trace events.
+// Включается флагом компиляции CHECKERS_TRACE. Тогда TRACE_SCOPE("имя") засекает время жизни
+// области видимости и кладёт событие в буфер своего потока (без блокировок и, пока буфер не
+// переполнен, без выделений памяти), а при завершении программы все буферы записываются
+// в trace.json. Файл открывается в chrome://tracing или ui.perfetto.dev.
+// Без флага TRACE_SCOPE ничего не делает.
+#ifdef CHECKERS_TRACE
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../Models/Project_path.h"
+
+namespace trace
+{
+// Завершённое событие: имя, начало и длительность в микросекундах от старта программы
+struct event
+{
+    const char *name;
+    int64_t start_us;
+    int64_t dur_us;
+};
+
+// Буфер событий одного потока. Пишет в него только владелец, читает сборщик после завершения потоков
+struct thread_buffer
+{
+    static constexpr size_t Reserve = 1 << 16;  // Событий без перевыделения памяти
+
+    explicit thread_buffer(const int tid) : tid(tid)
+    {
+        events.reserve(Reserve);
+    }
+
+    int tid;
+    std::vector<event> events;
+};
+
+// Сборщик буферов всех потоков, записывает trace.json при завершении программы
+class Collector
+{
+  public:
+    ~Collector()
+    {
+        std::ofstream fout(project_path + "trace.json", std::ios_base::trunc);
+        fout << "{\"traceEvents\":[";
+        bool first = true;
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto &buf : buffers)
+        {
+            for (const event &e : buf->events)
+            {
+                fout << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << e.start_us
+                     << ",\"dur\":" << e.dur_us << ",\"pid\":1,\"tid\":" << buf->tid << "}";
+                first = false;
+            }
+        }
+        fout << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    std::shared_ptr<thread_buffer> add()
+    {
+        auto buf = std::make_shared<thread_buffer>(next_tid++);
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.push_back(buf);
+        return buf;
+    }
+
+    int64_t now_us() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+  private:
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<int> next_tid{1};
+    std::mutex mtx;
+    std::vector<std::shared_ptr<thread_buffer>> buffers;  // Буферы живут дольше своих потоков
+};
+
+inline Collector &collector()
+{
+    static Collector instance;
+    return instance;
+}
+
+// Буфер текущего потока, создаётся при первом событии в потоке
+inline thread_buffer &local_buffer()
+{
+    thread_local std::shared_ptr<thread_buffer> buf = collector().add();
+    return *buf;
+}
+
+// Область профилирования: событие записывается при выходе из области
+class Scope
+{
+  public:
+    explicit Scope(const char *name) : name(name), start(collector().now_us())
+    {
+    }
+
+    ~Scope()
+    {
+        local_buffer().events.push_back({name, start, collector().now_us() - start});
+    }
+
+  private:
+    const char *name;
+    int64_t start;
+};
+}  // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
@@ -0,0 +1,282 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "Geometry.h"
+
+// Ключи Zobrist для хеширования позиций, вычисляемые на этапе компиляции
+template <int Cells> struct Basic_zobrist
+{
+    uint64_t piece[Cells][6];  // [клетка][тип фигуры 1..4, 5 - взятая фигура посреди серии], тип 0 не используется
+    uint64_t side[2];                    // Сторона хода
+    uint64_t parity[2];                  // Чётность глубины узла (минимизирующий или максимизирующий)
+    uint64_t scoring[2];                 // Способ оценки, чтобы разные настройки не смешивались в общей таблице
+};
+
+template <int Cells> constexpr Basic_zobrist<Cells> make_zobrist()
+{
+    Basic_zobrist<Cells> z{};
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    // splitmix64
+    auto next = [&seed]() {
+        uint64_t r = (seed += 0x9E3779B97F4A7C15ull);
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ull;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBull;
+        return r ^ (r >> 31);
+    };
+    for (int idx = 0; idx < Cells; ++idx)
+        for (int type = 1; type < 5; ++type)
+            z.piece[idx][type] = next();
+    for (int i = 0; i < 2; ++i)
+    {
+        z.side[i] = next();
+        z.parity[i] = next();
+        z.scoring[i] = next();
+    }
+    // Ключи взятых фигур генерируются последними, чтобы остальные ключи не менялись
+    for (int idx = 0; idx < Cells; ++idx)
+        z.piece[idx][5] = next();
+    return z;
+}
+
+template <int Cells> inline constexpr Basic_zobrist<Cells> basic_zobrist = make_zobrist<Cells>();
+
+// Хеш расположения фигур на доске N x N
+template <int N> inline uint64_t position_key(const basic_board_mtx<N> &mtx)
+{
+    constexpr const Basic_geometry<N> &g = basic_geometry<N>;
+    constexpr const Basic_zobrist<Basic_geometry<N>::Cells> &z = basic_zobrist<Basic_geometry<N>::Cells>;
+    uint64_t key = 0;
+    for (int idx = 0; idx < Basic_geometry<N>::Cells; ++idx)
+        key ^= z.piece[idx][mtx[g.cell[idx].x][g.cell[idx].y]];
+    return key;
+}
+
+// Таблица транспозиций для поиска Logic.
+// Доступ без блокировок: в слоте ключ хранится в XOR с данными, поэтому слот, частично
+// перезаписанный другим потоком, просто не пройдёт проверку. Это позволяет разделять одну
+// таблицу между поисками разных партий в разных потоках.
+// Таблица может жить в файле, отображённом в память: тогда результаты поиска переживают перезапуск
+// программы. Та же проверка XOR отбрасывает слоты, не дописанные из-за падения процесса.
+class Transposition_table
+{
+  public:
+    // Тип оценки в записи
+    enum class Bound : uint8_t
+    {
+        Exact,  // Точное значение
+        Lower,  // Значение не меньше записанного
+        Upper   // Значение не больше записанного
+    };
+
+    struct entry
+    {
+        double value;
+        int remaining;  // Оставшаяся глубина, на которой получено значение
+        Bound bound;
+    };
+
+    // Версия формата файла таблицы. Увеличивается при любом изменении оценки или ключей позиций,
+    // чтобы не читать значения, посчитанные старым кодом
+    static constexpr uint32_t File_version = 2;  // 2 - пачечная оценка листьев (Leaf_eval)
+
+    // Размер округляется вниз до степени двойки слотов
+    explicit Transposition_table(const size_t size_mb) : mask(slot_count(size_mb) - 1)
+    {
+        heap.reset(new slot[mask + 1]);
+        slots = heap.get();
+        clear();
+    }
+
+    // Таблица в файле path, отображённом в память. Файл с другой версией, размером или ключами,
+    // а также обрезанный файл создаются заново. Если файл открыть не удалось (или система
+    // не поддерживает отображение), таблица работает в памяти, а persistent() возвращает false
+    Transposition_table(const std::string &path, const size_t size_mb) : mask(slot_count(size_mb) - 1)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        map_size = sizeof(file_header) + (mask + 1) * sizeof(slot);
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0)
+        {
+            struct stat st;
+            const bool same_size = (fstat(fd, &st) == 0 && size_t(st.st_size) == map_size);
+            if (same_size || ftruncate(fd, off_t(map_size)) == 0)
+            {
+                void *p = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED)
+                    map = p;
+            }
+            close(fd);  // Отображение остаётся действительным и после закрытия файла
+            if (map)
+            {
+                header = static_cast<file_header *>(map);
+                slots = reinterpret_cast<slot *>(static_cast<char *>(map) + sizeof(file_header));
+                recovered = (same_size && header->valid(mask + 1) && !header->clean);
+                if (!same_size || !header->valid(mask + 1))
+                {
+                    // Новый или несовместимый файл: сначала помечаем заголовок неготовым, потом чистим слоты
+                    header->version = 0;
+                    clear();
+                    *header = file_header::make(mask + 1);
+                }
+                header->clean = 0;  // До закрытия таблицы файл может оказаться дописанным не до конца
+                msync(map, sizeof(file_header), MS_SYNC);
+                return;
+            }
+        }
+#else
+        (void)path;
+#endif
+        heap.reset(new slot[mask + 1]);
+        slots = heap.get();
+        clear();
+    }
+
+    Transposition_table(const Transposition_table &) = delete;
+    Transposition_table &operator=(const Transposition_table &) = delete;
+
+    ~Transposition_table()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map)
+        {
+            // Сначала сбрасываем слоты на диск, потом отмечаем, что файл закрыт корректно
+            msync(map, map_size, MS_SYNC);
+            header->clean = 1;
+            msync(map, sizeof(file_header), MS_SYNC);
+            munmap(map, map_size);
+        }
+#endif
+    }
+
+    // Хранится ли таблица в файле
+    bool persistent() const
+    {
+        return map != nullptr;
+    }
+
+    // Файл не был закрыт корректно в прошлый раз: данные используются, повреждённые слоты не пройдут проверку
+    bool recovered_after_crash() const
+    {
+        return recovered;
+    }
+
+    // Ищет запись позиции key, посчитанную не меньше чем на remaining оставшихся полуходов.
+    // Более глубокий результат (в том числе прошлых запусков) отвечает и на мелкий запрос;
+    // сначала смотрится слот самой глубокой записи
+    bool probe(const uint64_t key, const int remaining, entry &res) const
+    {
+        const slot *bucket = &slots[key & mask & ~size_t(1)];
+        for (int i = 0; i < 2; ++i)
+            if (read(bucket[i], key, res) && res.remaining >= remaining)
+                return true;
+        return false;
+    }
+
+    // Корзина из двух слотов: первый хранит самую глубокую запись, второй заменяется всегда.
+    // Так мелкие поиски (например, первые итерации углубления) не вытесняют глубокие результаты
+    void store(const uint64_t key, const double value, const int remaining, const Bound bound)
+    {
+        slot *bucket = &slots[key & mask & ~size_t(1)];
+        const uint64_t deep_meta = bucket[0].meta.load(std::memory_order_relaxed);
+        write(bucket[(!deep_meta || int(deep_meta >> 8) <= remaining) ? 0 : 1], key, value, remaining, bound);
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i <= mask; ++i)
+        {
+            slots[i].check.store(0, std::memory_order_relaxed);
+            slots[i].value.store(0, std::memory_order_relaxed);
+            slots[i].meta.store(0, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    struct slot
+    {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> value{0};
+        std::atomic<uint64_t> meta{0};
+    };
+
+    // Заголовок файла таблицы
+    struct file_header
+    {
+        char magic[8];
+        uint32_t version;    // File_version
+        uint32_t slot_size;  // sizeof(slot) на момент записи
+        uint64_t slots;      // Количество слотов
+        uint64_t keys;       // Отпечаток ключей Zobrist, чтобы не смешивать таблицы разных сборок
+        uint64_t clean;      // 1, если таблица была закрыта корректно
+
+        static uint64_t keys_signature()
+        {
+            return basic_zobrist<32>.piece[0][1] ^ basic_zobrist<50>.piece[0][1] ^ basic_zobrist<32>.side[1];
+        }
+
+        static file_header make(const uint64_t slots)
+        {
+            file_header h{{'C', 'H', 'K', 'R', 'S', 'T', 'T', 0}, File_version, sizeof(slot), slots, keys_signature(), 0};
+            return h;
+        }
+
+        bool valid(const uint64_t expected_slots) const
+        {
+            const file_header h = make(expected_slots);
+            return !std::memcmp(magic, h.magic, sizeof(magic)) && version == h.version && slot_size == h.slot_size &&
+                   slots == h.slots && keys == h.keys;
+        }
+    };
+
+    static bool read(const slot &s, const uint64_t key, entry &res)
+    {
+        const uint64_t value = s.value.load(std::memory_order_relaxed);
+        const uint64_t meta = s.meta.load(std::memory_order_relaxed);
+        if ((s.check.load(std::memory_order_relaxed) ^ value ^ meta) != key || !meta)
+            return false;
+        std::memcpy(&res.value, &value, sizeof(value));
+        res.remaining = int(meta >> 8);
+        res.bound = Bound((meta & 0xFF) - 1);
+        return true;
+    }
+
+    static void write(slot &s, const uint64_t key, const double value, const int remaining, const Bound bound)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        // Тип оценки хранится со сдвигом на 1, чтобы нулевые meta означали пустой слот
+        const uint64_t meta = (uint64_t(remaining) << 8) | (uint64_t(bound) + 1);
+        s.check.store(key ^ bits ^ meta, std::memory_order_relaxed);
+        s.value.store(bits, std::memory_order_relaxed);
+        s.meta.store(meta, std::memory_order_relaxed);
+    }
+
+    // Количество слотов: степень двойки, не меньше двух (одна корзина)
+    static size_t slot_count(const size_t size_mb)
+    {
+        size_t cnt = 2;
+        while (cnt * 2 * sizeof(slot) <= size_mb * 1024 * 1024)
+            cnt *= 2;
+        return cnt;
+    }
+
+    std::unique_ptr<slot[]> heap;  // Слоты в памяти, если таблица не в файле
+    slot *slots = nullptr;
+    size_t mask = 0;
+
+    // Отображение файла: заголовок и слоты сразу за ним
+    void *map = nullptr;
+    size_t map_size = 0;
+    file_header *header = nullptr;
+    bool recovered = false;
+};
@@ -0,0 +1,258 @@
+#pragma once
+// Запись дерева поиска в двоичный файл для разбора плохих ходов бота.
+// Включается флагом компиляции CHECKERS_TREE_CAPTURE. Тогда каждый узел find_best_turns_rec при выходе
+// пишет запись фиксированного размера: ключ позиции, ход в узел, глубину, окно альфа-бета на входе,
+// оценку и причину выхода (отсечение, таблица транспозиций, горизонт и т.д.). Записи копятся в буфере
+// и дописываются в файл пачками; после max_mb мегабайт запись прекращается, а в заголовке отмечается, что
+// файл обрезан, поэтому и память, и диск ограничены. Файл читает tree_reader.cpp.
+// Без флага макросы TREE_* ничего не делают и поиск не меняется.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../Models/Move.h"
+
+// Причина, по которой узел вернул оценку
+enum class Tree_reason : uint8_t
+{
+    Root,       // Корень поиска (ход бота)
+    Exact,      // Все ходы просмотрены, оценка внутри окна
+    Fail_low,   // Все ходы просмотрены, оценка не выше alpha на входе
+    Fail_high,  // Все ходы просмотрены, оценка не ниже beta на входе
+    Cutoff,     // Альфа-бета отсечение: остальные ходы не просматривались
+    Tt_hit,     // Оценка взята из таблицы транспозиций
+    Horizon,    // Достигнута глубина поиска, статическая оценка
+    No_moves,   // Ходить нечем
+    Chain_end,  // Серия взятий закончилась, оценка - от узла соперника
+    Stopped     // Поиск отменён
+};
+
+// Запись узла в файле
+struct tree_record
+{
+    uint64_t key;      // Ключ Zobrist позиции и стороны хода
+    uint32_t search;   // Номер поиска (хода бота) в файле
+    uint32_t id;       // Номер узла в поиске, корень - 0
+    uint32_t parent;   // Номер родителя
+    float alpha, beta; // Окно на входе
+    float score;       // Возвращённая оценка
+    int8_t x, y, x2, y2;  // Ход в узел (одна фигура, один прыжок), -1 - нет хода
+    uint8_t ply;       // Полных ходов от корня
+    uint8_t reason;    // Tree_reason
+    uint8_t flags;     // Flag_*
+    uint8_t searched;  // Для Cutoff - сколько ходов просмотрено до отсечения
+    uint8_t total;     // Сколько ходов было у узла
+    uint8_t pad[3];
+};
+
+// Заголовок файла
+struct tree_file_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t board_size;
+    uint32_t truncated;  // 1, если запись остановлена из-за предела размера
+};
+
+class Tree_capture
+{
+  public:
+    static constexpr uint32_t Version = 1;
+    static constexpr uint8_t Flag_white_to_move = 1, Flag_black_to_move = 2, Flag_capture = 4, Flag_continuation = 8;
+    static constexpr size_t Default_mb = 256;
+
+    Tree_capture(const std::string &path, const int board_size, const size_t max_mb = Default_mb)
+        : max_records((max_mb << 20) / sizeof(tree_record)), file(std::fopen(path.c_str(), "wb"))
+    {
+        header = {{'C', 'H', 'K', 'R', 'T', 'R', 'E', 0}, Version, sizeof(tree_record), uint32_t(board_size), 0};
+        if (file)
+            std::fwrite(&header, sizeof(header), 1, file);
+        buffer.reserve(Buffer_records);
+        stack.reserve(256);
+    }
+
+    Tree_capture(const Tree_capture &) = delete;
+    Tree_capture &operator=(const Tree_capture &) = delete;
+
+    ~Tree_capture()
+    {
+        if (!file)
+            return;
+        flush();
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+    }
+
+    // Начало поиска от корня с ключом key
+    void begin_search(const uint64_t key, const bool color)
+    {
+        ++search;
+        next_id = 1;
+        stack.assign(1, 0);
+        pending = no_move();
+        root = blank(key, 0, color);
+        root.alpha = -1;
+        root.beta = float(1e9 + 1);
+    }
+
+    // Конец поиска: пишет корень с итоговой оценкой
+    void end_search(const double score)
+    {
+        root.score = float(score);
+        root.reason = uint8_t(Tree_reason::Root);
+        write(root);
+        stack.clear();
+        flush();
+    }
+
+    // Ход, которым будет достигнут следующий открытый узел
+    void set_move(const move_pos &turn)
+    {
+        pending = {int8_t(turn.x), int8_t(turn.y), int8_t(turn.x2), int8_t(turn.y2), turn.xb != -1};
+    }
+
+    // Лист, оценённый без рекурсивного вызова (пачкой у горизонта)
+    void leaf(const move_pos &turn, const uint64_t key, const int ply, const bool color, const double alpha,
+              const double beta, const double score)
+    {
+        set_move(turn);
+        tree_record r = blank(key, ply, color);
+        r.id = next_id++;
+        r.alpha = float(alpha);
+        r.beta = float(beta);
+        r.score = float(score);
+        r.reason = uint8_t(Tree_reason::Horizon);
+        write(r);
+    }
+
+    // Узел на время вызова find_best_turns_rec: номер и родитель берутся при входе, запись - в finish
+    class node_scope
+    {
+      public:
+        node_scope(Tree_capture *capture, const uint64_t key, const int ply, const bool color, const double alpha,
+                   const double beta, const bool continuation)
+            : capture(capture)
+        {
+            if (!capture)
+                return;
+            rec = capture->blank(key, ply, color);
+            rec.id = capture->next_id++;
+            rec.alpha = float(alpha);
+            rec.beta = float(beta);
+            if (continuation)
+                rec.flags |= Flag_continuation;
+            capture->stack.push_back(rec.id);
+        }
+
+        ~node_scope()
+        {
+            if (capture && open)
+                capture->stack.pop_back();
+        }
+
+        double finish(const double score, const Tree_reason reason, const size_t searched = 0, const size_t total = 0)
+        {
+            if (!capture)
+                return score;
+            rec.score = float(score);
+            rec.reason = uint8_t(reason);
+            rec.searched = uint8_t(searched < 255 ? searched : 255);
+            rec.total = uint8_t(total < 255 ? total : 255);
+            capture->stack.pop_back();
+            open = false;
+            capture->write(rec);
+            return score;
+        }
+
+      private:
+        Tree_capture *capture;
+        tree_record rec{};
+        bool open = true;
+    };
+
+  private:
+    static constexpr size_t Buffer_records = 1 << 14;  // Записей в буфере до записи в файл
+
+    struct pending_move
+    {
+        int8_t x, y, x2, y2;
+        bool capture;
+    };
+
+    static pending_move no_move()
+    {
+        return {-1, -1, -1, -1, false};
+    }
+
+    // Запись узла с ключом, ходом из pending и родителем с вершины стека
+    tree_record blank(const uint64_t key, const int ply, const bool color)
+    {
+        tree_record r{};
+        r.key = key;
+        r.search = search;
+        r.parent = stack.empty() ? 0 : stack.back();
+        r.x = pending.x;
+        r.y = pending.y;
+        r.x2 = pending.x2;
+        r.y2 = pending.y2;
+        r.ply = uint8_t(ply < 255 ? ply : 255);
+        r.flags = uint8_t((color ? Flag_black_to_move : Flag_white_to_move) | (pending.capture ? Flag_capture : 0));
+        pending = no_move();
+        return r;
+    }
+
+    void write(const tree_record &r)
+    {
+        if (written + buffer.size() >= max_records)
+        {
+            header.truncated = 1;
+            return;
+        }
+        buffer.push_back(r);
+        if (buffer.size() == Buffer_records)
+            flush();
+    }
+
+    void flush()
+    {
+        if (file && !buffer.empty())
+            std::fwrite(buffer.data(), sizeof(tree_record), buffer.size(), file);
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    size_t max_records;  // Предел размера файла в записях
+    std::FILE *file;
+    tree_file_header header;
+    std::vector<tree_record> buffer;
+    std::vector<uint32_t> stack;  // Номера открытых узлов от корня
+    size_t written = 0;
+    uint32_t search = 0;
+    uint32_t next_id = 0;
+    pending_move pending = no_move();
+    tree_record root{};
+};
+
+#ifdef CHECKERS_TREE_CAPTURE
+// Открывает узел find_best_turns_rec (ключ считается, только если запись включена)
+#define TREE_NODE(mtx, color, depth, alpha, beta, continuation)                                                      \
+    Tree_capture::node_scope tree_node(tree,                                                                         \
+                                       tree ? position_key<Geometry::Size>(mtx) ^ zobrist.side[color] : 0,           \
+                                       int(depth) + 1, color, alpha, beta, continuation)
+#define TREE_RESULT(value, reason, ...) tree_node.finish(value, reason, ##__VA_ARGS__)
+#define TREE_MOVE(turn) (tree ? tree->set_move(turn) : void())
+// Лист у горизонта, оценённый пачкой: ход turn из позиции mtx стороны color
+#define TREE_LEAF(mtx, turn, color, depth, alpha, beta, score)                                                        \
+    (tree ? tree->leaf(turn, position_key<Geometry::Size>(make_turn(mtx, turn)) ^ zobrist.side[!(color)],            \
+                       int(depth) + 2, !(color), alpha, beta, score)                                                  \
+          : void())
+#else
+#define TREE_NODE(mtx, color, depth, alpha, beta, continuation)
+#define TREE_RESULT(value, reason, ...) (value)
+#define TREE_MOVE(turn) ((void)0)
+#define TREE_LEAF(mtx, turn, color, depth, alpha, beta, score) ((void)0)
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+#include <cassert>
+#include <new>
+
+#include "Move.h"
+
+// Список ходов фиксированной ёмкости, целиком лежащий на стеке.
+// Используется в поиске вместо vector<move_pos>, чтобы узлы дерева не обращались к куче.
+class move_list
+{
+  public:
+    // Больше максимального числа ходов в позиции. В списке либо только взятия, либо только тихие ходы.
+    // На пустую клетку можно прийти не больше чем с 4 направлений, и с каждого ходит только ближайшая
+    // фигура на луче (при взятии - ближайшая за побитой). Поэтому ходов не больше 4 * (игровые клетки):
+    // 128 на 8x8 и 200 на 10x10. Draughts_logic проверяет эту границу static_assert для своей доски
+    static constexpr size_t Capacity = 256;
+
+    move_list()
+    {
+    }
+    move_list(const move_list &other) : cnt(other.cnt)
+    {
+        // Копируем только занятую часть буфера
+        for (size_t i = 0; i < cnt; ++i)
+            new (&items[i]) move_pos(other.items[i]);
+    }
+    move_list &operator=(const move_list &other)
+    {
+        cnt = other.cnt;
+        for (size_t i = 0; i < cnt; ++i)
+            new (&items[i]) move_pos(other.items[i]);
+        return *this;
+    }
+
+    template <class... Args> void emplace_back(const Args... args)
+    {
+        assert(cnt < Capacity && "move_list overflow");
+        new (&items[cnt++]) move_pos(args...);
+    }
+    void push_back(const move_pos &turn)
+    {
+        assert(cnt < Capacity && "move_list overflow");
+        new (&items[cnt++]) move_pos(turn);
+    }
+    // Добавляет в конец все ходы другого списка
+    void append(const move_list &other)
+    {
+        for (const auto &turn : other)
+            push_back(turn);
+    }
+    void clear()
+    {
+        cnt = 0;
+    }
+
+    bool empty() const
+    {
+        return cnt == 0;
+    }
+    size_t size() const
+    {
+        return cnt;
+    }
+    move_pos &operator[](const size_t i)
+    {
+        return items[i];
+    }
+    const move_pos &operator[](const size_t i) const
+    {
+        return items[i];
+    }
+    move_pos *begin()
+    {
+        return items;
+    }
+    move_pos *end()
+    {
+        return items + cnt;
+    }
+    const move_pos *begin() const
+    {
+        return items;
+    }
+    const move_pos *end() const
+    {
+        return items + cnt;
+    }
+
+  private:
+    // Буфер не инициализируется при создании списка, ходы конструируются по мере добавления
+    union {
+        move_pos items[Capacity];
+    };
+    size_t cnt = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+
+// Способ оценки позиции ботом (BotScoringType)
+enum class Scoring
+{
+    NumberOnly,         // Учитывается только количество фигур
+    NumberAndPotential  // Учитываются ещё и позиции фигур
+};
+
+// Уровень оптимизации перебора (Optimization)
+enum class Optimization
+{
+    O0,  // Без отсечений
+    O1,  // Альфа-бета отсечение
+    O2   // Зарезервировано
+};
+
+// Движок бота (WhiteBotEngine / BlackBotEngine)
+enum class Bot_engine
+{
+    AlphaBeta,  // Перебор с альфа-бета отсечением (Logic)
+    MCTS        // Поиск по дереву Монте-Карло (Mcts)
+};
+
+// Типизированный снимок настроек из settings.json.
+// Заполняется один раз при чтении файла, дальше читается без поиска по строкам.
+struct Settings
+{
+    unsigned width = 0;   // WindowSize.Width
+    unsigned height = 0;  // WindowSize.Hight
+
+    bool is_bot[2] = {false, true};  // IsWhiteBot / IsBlackBot, индекс - цвет (0 - белые, 1 - чёрные)
+    int bot_level[2] = {0, 5};       // WhiteBotLevel / BlackBotLevel
+    Scoring scoring = Scoring::NumberAndPotential;
+    unsigned delay_ms = 0;  // BotDelayMS
+    bool no_random = false;
+    Optimization optimization = Optimization::O1;
+    std::string cache_file;  // CacheFile: файл долговременной таблицы транспозиций, пустая строка - без неё
+    unsigned cache_mb = 64;  // CacheMB: размер этой таблицы
+    unsigned solver_mb = 4;  // SolverMB: память решателя форсированных выигрышей, 0 - без него
+    Bot_engine engine[2] = {Bot_engine::AlphaBeta, Bot_engine::AlphaBeta};  // WhiteBotEngine / BlackBotEngine
+    unsigned mcts_time_ms = 1000;  // MctsTimeMS: время MCTS на ход
+    unsigned mcts_threads = 0;     // MctsThreads: потоки MCTS, 0 - по числу ядер
+    unsigned mcts_mb = 64;         // MctsMB: память дерева MCTS
+
+    int max_turns = 120;  // Game.MaxNumTurns
+    std::string save_file;  // Game.SaveFile: снимок партии для возобновления, пустая строка - не сохранять
+};
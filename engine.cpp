@@ -0,0 +1,12 @@
+// Консольный движок без SDL для запуска из внешних оркестраторов (протокол описан в Game/Engine.h)
+// Использование: engine [файл таблицы транспозиций [размер в МБ]]
+#define CHECKERS_HEADLESS
+#include <cstdlib>
+
+#include "Game/Engine.h"
+
+int main(int argc, char *argv[])
+{
+    Engine engine(argc > 1 ? argv[1] : "", argc > 2 ? size_t(atoi(argv[2])) : 64);
+    return engine.loop();
+}
@@ -0,0 +1,35 @@
+// Ферма партий бот против бота в отдельных процессах (Game/Match_farm.h), без SDL.
+// Использование: farm [партий] [процессов, 0 - по числу ядер] [уровень белых] [уровень чёрных] [предел ходов]
+//                     [мс на партию до перезапуска зависшего рабочего]
+#define CHECKERS_HEADLESS
+#include <cstdlib>
+#include <iostream>
+
+#include "Game/Match_farm.h"
+
+int main(int argc, char *argv[])
+{
+    farm_settings settings;
+    if (argc > 1)
+        settings.games = atoi(argv[1]);
+    if (argc > 2)
+        settings.workers = atoi(argv[2]);
+    if (argc > 3)
+        settings.level[0] = settings.level[1] = atoi(argv[3]);
+    if (argc > 4)
+        settings.level[1] = atoi(argv[4]);
+    if (argc > 5)
+        settings.max_turns = atoi(argv[5]);
+    if (argc > 6)
+        settings.game_timeout_ms = atoi(argv[6]);
+
+    Match_farm farm(settings);
+    const farm_stats stats = farm.run();
+    const double sec = stats.ms / 1000;
+    cout << "Games: " << settings.games << " (white " << stats.results[1] << ", black " << stats.results[2]
+         << ", draw " << stats.results[0] << ", failed " << stats.failed << ") in " << (long long)stats.ms << " ms on "
+         << farm.workers_count() << " workers, " << stats.restarts << " restarts (" << stats.timeouts << " hung)\n";
+    cout << "Games/s: " << settings.games / sec << ", moves: " << stats.turns << ", nodes/s: " << (long long)(stats.nodes / sec)
+         << endl;
+    return stats.failed ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+// Нагрузочный запуск Game_host без SDL: N партий бот против бота на общем пуле потоков.
+// Использование: host [партий] [потоков] [размер общей таблицы транспозиций в МБ, 0 - без неё]
+#define CHECKERS_HEADLESS
+#include <cstdlib>
+#include <iostream>
+
+#include "Game/Game_host.h"
+
+int main(int argc, char *argv[])
+{
+    const int games = (argc > 1 ? atoi(argv[1]) : 100);
+    const size_t threads = (argc > 2 ? size_t(atoi(argv[2])) : thread::hardware_concurrency());
+    const size_t tt_mb = (argc > 3 ? size_t(atoi(argv[3])) : 64);
+
+    Settings settings;
+    settings.is_bot[0] = settings.is_bot[1] = true;
+    settings.bot_level[0] = settings.bot_level[1] = 5;
+
+    auto start = chrono::steady_clock::now();
+    Game_host host(threads, tt_mb);
+    for (int i = 0; i < games; ++i)
+        host.create_session(settings);
+    host.wait_all();
+    const auto ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    int results[3] = {0, 0, 0};
+    for (int i = 0; i < games; ++i)
+        ++results[host.state(i).result];
+    const latency_stats stats = host.stats_all();
+    cout << "Games: " << games << " (white " << results[1] << ", black " << results[2] << ", draw " << results[0]
+         << ") in " << (long long)ms << " ms on " << threads << " threads\n";
+    cout << "Bot moves: " << stats.count << ", latency ms: mean " << stats.mean << ", p50 " << stats.p50 << ", p95 "
+         << stats.p95 << ", p99 " << stats.p99 << ", max " << stats.max << endl;
+    return 0;
+}
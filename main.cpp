@@ -1,7 +1,26 @@
+#include "Game/Bench.h"
 #include "Game/Game.h"
+#include "Game/Render_bench.h"
 
 int main(int argc, char* argv[])
 {
+    // Микробенчмарк оценки листьев: Checkers bench eval
+    if (argc > 2 && string(argv[1]) == "bench" && string(argv[2]) == "eval")
+        return Bench().run_eval();
+    // Бенчмарк отрисовки без дисплея: Checkers bench render [ходов]
+    if (argc > 2 && string(argv[1]) == "bench" && string(argv[2]) == "render")
+        return Render_bench().run(argc > 3 ? stoi(argv[3]) : 200);
+    // Бенчмарк генерации ходов: Checkers bench movegen
+    if (argc > 2 && string(argv[1]) == "bench" && string(argv[2]) == "movegen")
+        return Bench().run_movegen();
+    // Сравнение MCTS с альфа-бета поиском: Checkers bench mcts [партий] [мс на ход] [потоков]
+    if (argc > 2 && string(argv[1]) == "bench" && string(argv[2]) == "mcts")
+        return Bench().run_mcts(argc > 3 ? stoi(argv[3]) : 10, argc > 4 ? stoul(argv[4]) : 200,
+                                argc > 5 ? stoul(argv[5]) : 0);
+    // Режим бенчмарка поиска: Checkers bench [ожидаемая сигнатура]
+    if (argc > 1 && string(argv[1]) == "bench")
+        return Bench().run(argc > 2 ? stoull(argv[2]) : 0);
+
     Game g;
     g.play();
 
@@ -0,0 +1,32 @@
+// Генератор обучающих данных партиями бот против бота (Game/Self_play.h), без SDL.
+// Использование: selfplay [партий] [потоков, 0 - по числу ядер] [глубина] [случайных ходов в начале] [каталог]
+#define CHECKERS_HEADLESS
+#include <cstdlib>
+#include <iostream>
+
+#include "Game/Self_play.h"
+
+int main(int argc, char *argv[])
+{
+    self_play_settings settings;
+    if (argc > 1)
+        settings.games = atoi(argv[1]);
+    if (argc > 2)
+        settings.threads = size_t(atoi(argv[2]));
+    if (argc > 3)
+        settings.depth[0] = settings.depth[1] = atoi(argv[3]);
+    if (argc > 4)
+        settings.random_plies = atoi(argv[4]);
+    if (argc > 5)
+        settings.dir = argv[5];
+
+    Self_play generator(settings);
+    const self_play_stats stats = generator.run();
+    cout << "Games: " << settings.games << " (white " << stats.results[1] << ", black " << stats.results[2]
+         << ", draw " << stats.results[0] << ") in " << (long long)stats.ms << " ms on " << generator.threads_count()
+         << " threads\n";
+    cout << "Positions: " << stats.positions << ", written " << stats.written << ", duplicates " << stats.duplicates
+         << ", shards " << stats.shards << " in " << settings.dir << ", positions/s "
+         << (long long)(stats.positions / (stats.ms / 1000)) << endl;
+    return stats.written + stats.duplicates == stats.positions ? 0 : 1;
+}
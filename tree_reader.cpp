@@ -0,0 +1,244 @@
+// Чтение файла дерева поиска, записанного сборкой с CHECKERS_TREE_CAPTURE (search_tree.bin).
+// Использование:
+//   tree_reader файл                              - сводка: поиски, узлы по глубине и причинам выхода
+//   tree_reader файл why ход глубина [поиск]      - почему ход (c3-d4 или c3:e5) на этой глубине не выбран
+//   tree_reader файл node номер [поиск]           - узел, путь к нему от корня и его дети
+// Поиск по умолчанию - последний в файле (последний ход бота).
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Game/Tree_capture.h"
+
+using namespace std;
+
+static const char *const reason_names[] = {"root",    "exact",   "fail-low", "fail-high", "cutoff",
+                                           "tt-hit",  "horizon", "no-moves", "chain-end", "stopped"};
+static constexpr size_t Reason_count = sizeof(reason_names) / sizeof(reason_names[0]);
+
+static constexpr size_t Max_listed = 10;  // Сколько узлов печатать подробно
+static int board_size = 8;
+
+static string square(const int x, const int y)
+{
+    return string(1, char('a' + y)) + to_string(board_size - x);
+}
+
+static string move_text(const tree_record &r)
+{
+    if (r.x < 0)
+        return "-";
+    return square(r.x, r.y) + ((r.flags & Tree_capture::Flag_capture) ? ":" : "-") + square(r.x2, r.y2);
+}
+
+// Разбирает ход c3-d4 / c3:e5 в координаты
+static bool parse_move(const string &text, int &x, int &y, int &x2, int &y2)
+{
+    const size_t sep = text.find_first_of("-:");
+    if (sep == string::npos || sep < 2 || text.size() < sep + 3)
+        return false;
+    auto cell = [](const string &s, int &cx, int &cy) {
+        cy = s[0] - 'a';
+        cx = board_size - stoi(s.substr(1));
+        return cx >= 0 && cx < board_size && cy >= 0 && cy < board_size;
+    };
+    return cell(text.substr(0, sep), x, y) && cell(text.substr(sep + 1), x2, y2);
+}
+
+static void print(const tree_record &r)
+{
+    cout << "#" << r.id << " ply " << int(r.ply) << " " << move_text(r)
+         << ((r.flags & Tree_capture::Flag_continuation) ? " (capture continues)" : "") << " window [" << r.alpha
+         << ", " << r.beta << "] score " << r.score << " "
+         << (r.reason < Reason_count ? reason_names[r.reason] : "?");
+    if (r.reason == uint8_t(Tree_reason::Cutoff))
+        cout << " after " << int(r.searched) << " of " << int(r.total) << " moves";
+    cout << "\n";
+}
+
+// Узлы одного поиска с доступом по номеру
+struct search_tree
+{
+    vector<tree_record> nodes;  // По номеру узла, отсутствующие - с search == 0
+    vector<vector<uint32_t>> children;
+
+    const tree_record *get(const uint32_t id) const
+    {
+        return id < nodes.size() && nodes[id].search ? &nodes[id] : nullptr;
+    }
+};
+
+static search_tree load_search(const vector<tree_record> &all, const uint32_t search)
+{
+    search_tree t;
+    for (const auto &r : all)
+    {
+        if (r.search != search)
+            continue;
+        if (r.id >= t.nodes.size())
+            t.nodes.resize(r.id + 1, tree_record{}), t.children.resize(r.id + 1);
+        t.nodes[r.id] = r;
+    }
+    for (const auto &r : t.nodes)
+        if (r.search && r.id != 0)
+            t.children[r.parent].push_back(r.id);
+    return t;
+}
+
+static void print_path(const search_tree &t, uint32_t id)
+{
+    vector<string> moves;
+    while (id != 0)
+    {
+        const tree_record *r = t.get(id);
+        if (!r)
+            break;
+        moves.push_back(move_text(*r));
+        id = r->parent;
+    }
+    cout << "  path:";
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it)
+        cout << " " << *it;
+    cout << "\n";
+}
+
+static int summary(const vector<tree_record> &all, const tree_file_header &h)
+{
+    uint32_t searches = 0;
+    vector<array<size_t, Reason_count>> by_ply;
+    for (const auto &r : all)
+    {
+        searches = max(searches, r.search);
+        if (r.ply >= by_ply.size())
+            by_ply.resize(r.ply + 1, array<size_t, Reason_count>{});
+        if (r.reason < Reason_count)
+            ++by_ply[r.ply][r.reason];
+    }
+    cout << "Records: " << all.size() << ", searches: " << searches << (h.truncated ? ", truncated by size cap" : "")
+         << "\nply";
+    for (const char *name : reason_names)
+        cout << setw(11) << name;
+    cout << "\n";
+    for (size_t ply = 0; ply < by_ply.size(); ++ply)
+    {
+        cout << setw(3) << ply;
+        for (const size_t n : by_ply[ply])
+            cout << setw(11) << n;
+        cout << "\n";
+    }
+    return 0;
+}
+
+// Почему ход на глубине ply не стал лучшим: оценки узлов после него или отсечения, из-за которых его не смотрели
+static int why(const search_tree &t, const string &text, const int ply)
+{
+    int x, y, x2, y2;
+    if (!parse_move(text, x, y, x2, y2))
+    {
+        cerr << "Bad move " << text << ", expected like c3-d4 or c3:e5\n";
+        return 1;
+    }
+    size_t found = 0;
+    for (const auto &r : t.nodes)
+    {
+        if (!r.search || r.ply != ply || r.x != x || r.y != y || r.x2 != x2 || r.y2 != y2)
+            continue;
+        if (found++ < Max_listed)
+        {
+            print(r);
+            print_path(t, r.parent);
+            if (const tree_record *p = t.get(r.parent))
+            {
+                cout << "  parent: ";
+                print(*p);
+            }
+        }
+    }
+    if (found)
+    {
+        cout << found << " node(s) after " << text << " at ply " << ply << "\n";
+        return 0;
+    }
+
+    // Хода нет среди узлов: ищем родителей, у которых перебор оборвался отсечением
+    size_t cut = 0;
+    for (const auto &p : t.nodes)
+    {
+        if (!p.search || p.ply + 1 != ply || p.reason != uint8_t(Tree_reason::Cutoff) || p.searched >= p.total)
+            continue;
+        if (cut++ < Max_listed)
+        {
+            cout << "cut before the remaining moves: ";
+            print(p);
+            print_path(t, p.id);
+            // Отсечение вызвал последний просмотренный ребёнок
+            const auto &kids = t.children[p.id];
+            if (!kids.empty())
+            {
+                cout << "  refuted by: ";
+                print(t.nodes[*max_element(kids.begin(), kids.end())]);
+            }
+        }
+    }
+    cout << text << " was never searched at ply " << ply << "; " << cut
+         << " node(s) one ply above were cut off before all their moves were searched\n";
+    return 0;
+}
+
+static int node(const search_tree &t, const uint32_t id)
+{
+    const tree_record *r = t.get(id);
+    if (!r)
+    {
+        cerr << "No node #" << id << "\n";
+        return 1;
+    }
+    print(*r);
+    print_path(t, id);
+    for (const uint32_t c : t.children[id])
+    {
+        cout << "  ";
+        print(t.nodes[c]);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: tree_reader file [why move ply [search] | node id [search]]\n";
+        return 1;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    tree_file_header h;
+    if (!f || fread(&h, sizeof(h), 1, f) != 1 || string(h.magic) != "CHKRTRE" || h.version != Tree_capture::Version ||
+        h.record_size != sizeof(tree_record))
+    {
+        cerr << "Not a search tree file of this version: " << argv[1] << "\n";
+        return 1;
+    }
+    board_size = int(h.board_size);
+    vector<tree_record> all;
+    tree_record r;
+    while (fread(&r, sizeof(r), 1, f) == 1)
+        all.push_back(r);
+    fclose(f);
+
+    const string cmd = (argc > 2 ? argv[2] : "");
+    if (cmd.empty())
+        return summary(all, h);
+    uint32_t last = 0;
+    for (const auto &rec : all)
+        last = max(last, rec.search);
+    if (cmd == "why" && argc > 4)
+        return why(load_search(all, argc > 5 ? uint32_t(stoul(argv[5])) : last), argv[3], stoi(argv[4]));
+    if (cmd == "node" && argc > 3)
+        return node(load_search(all, argc > 4 ? uint32_t(stoul(argv[4])) : last), uint32_t(stoul(argv[3])));
+    cerr << "Unknown command " << cmd << "\n";
+    return 1;
+}